@@ -0,0 +1,149 @@
+/**
+ *   Measures how compile time grows with the number of shared pointer
+ * handlers, for two ways of choosing between them:
+ *
+ *   - exclusive: the scheme in SingleSubclassSpecificSharedPtrFunctionSpecializations.cpp,
+ *     where each handler's enable_if condition also rules out every
+ *     handler that should take precedence over it, and the generic case
+ *     rules out all of them
+ *   - ranked: the scheme in PriorityRankedSharedPtrFunctionSpecializations.cpp,
+ *     where each handler is a specialization at its own priority
+ *
+ *   For each handler count, a source file using each scheme is generated
+ * into the temporary directory, and the compiler is timed checking it
+ * (-fsyntax-only). Every handler is used by one type, and one more type
+ * falls through to the generic case. The compiler is $CXX if set, or c++
+ * otherwise.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+std::string generateExclusive(int handlerCount) {
+    std::ostringstream source {};
+    source << "#include <memory>\n#include <type_traits>\n\n"
+        << "template <int I> struct Base {};\n"
+        << "template <int I> struct Derived: Base<I> {};\n"
+        << "struct Plain {};\n\n"
+        << "template <typename T> struct MyPrint;\n"
+        << "template <typename T> struct MyPrint<std::shared_ptr<T>> {\n";
+
+    // a higher numbered handler takes precedence over a lower numbered one
+    for(int handler{0}; handler < handlerCount; ++handler) {
+        source << "    template <typename U=T, typename std::enable_if<std::is_base_of<Base<" << handler << ">, U>::value";
+        for(int preferred{handler + 1}; preferred < handlerCount; ++preferred) {
+            source << " && !std::is_base_of<Base<" << preferred << ">, U>::value";
+        }
+        source << ", bool>::type = true>\n"
+            << "    static int print() { return " << handler << "; }\n";
+    }
+
+    source << "    template <typename U=T, typename std::enable_if<true";
+    for(int handler{0}; handler < handlerCount; ++handler) {
+        source << " && !std::is_base_of<Base<" << handler << ">, U>::value";
+    }
+    source << ", bool>::type = true>\n"
+        << "    static int print() { return -1; }\n"
+        << "};\n\n";
+
+    source << "int main() {\n    int total { 0 };\n";
+    for(int handler{0}; handler < handlerCount; ++handler) {
+        source << "    total += MyPrint<std::shared_ptr<Derived<" << handler << ">>>::print();\n";
+    }
+    source << "    total += MyPrint<std::shared_ptr<Plain>>::print();\n"
+        << "    return total;\n}\n";
+    return source.str();
+}
+
+std::string generateRanked(int handlerCount) {
+    std::ostringstream source {};
+    source << "#include <memory>\n#include <type_traits>\n\n"
+        << "template <int I> struct Base {};\n"
+        << "template <int I> struct Derived: Base<I> {};\n"
+        << "struct Plain {};\n\n"
+        << "constexpr int kMaxPrintPriority { " << handlerCount << " };\n"
+        << "template <int Priority> struct PrintPrioritySlot {};\n"
+        << "template <int Priority> struct CheckPrintPriority {\n"
+        << "    static_assert(Priority >= 0 && Priority <= kMaxPrintPriority, \"priority out of range\");\n"
+        << "    using type = PrintPrioritySlot<Priority>;\n"
+        << "};\n"
+        << "template <int Priority> using PrintPriority = typename CheckPrintPriority<Priority>::type;\n"
+        << "template <typename TPriority, typename T, typename Enable=void>\n"
+        << "struct SharedPtrPrint { static constexpr bool kAccepts { false }; };\n"
+        << "template <typename T, int Priority=kMaxPrintPriority>\n"
+        << "struct SelectSharedPtrPrint: std::conditional<\n"
+        << "    SharedPtrPrint<PrintPriority<Priority>, T>::kAccepts,\n"
+        << "    SharedPtrPrint<PrintPriority<Priority>, T>,\n"
+        << "    SelectSharedPtrPrint<T, Priority - 1>\n"
+        << ">::type {};\n"
+        << "template <typename T> struct SelectSharedPtrPrint<T, -1> {};\n\n"
+        << "template <typename T> struct MyPrint;\n"
+        << "template <typename T> struct MyPrint<std::shared_ptr<T>>: SelectSharedPtrPrint<T> {};\n\n"
+        << "template <typename T> struct SharedPtrPrint<PrintPriority<0>, T> {\n"
+        << "    static constexpr bool kAccepts { true };\n"
+        << "    static int print() { return -1; }\n"
+        << "};\n";
+
+    // handler n sits at priority n + 1, above the generic case
+    for(int handler{0}; handler < handlerCount; ++handler) {
+        source << "template <typename T> struct SharedPtrPrint<PrintPriority<" << handler + 1
+            << ">, T, typename std::enable_if<std::is_base_of<Base<" << handler << ">, T>::value>::type> {\n"
+            << "    static constexpr bool kAccepts { true };\n"
+            << "    static int print() { return " << handler << "; }\n"
+            << "};\n";
+    }
+
+    source << "\nint main() {\n    int total { 0 };\n";
+    for(int handler{0}; handler < handlerCount; ++handler) {
+        source << "    total += MyPrint<std::shared_ptr<Derived<" << handler << ">>>::print();\n";
+    }
+    source << "    total += MyPrint<std::shared_ptr<Plain>>::print();\n"
+        << "    return total;\n}\n";
+    return source.str();
+}
+
+// Best of a few runs, in milliseconds, or a negative number if the
+// generated source failed to compile
+double timeCompilation(const std::string& compiler, const std::filesystem::path& sourcePath, const std::string& source) {
+    std::ofstream { sourcePath } << source;
+    const std::string command { compiler + " -std=c++17 -fsyntax-only " + sourcePath.string() };
+
+    constexpr int runs { 3 };
+    double best {};
+    for(int run{0}; run < runs; ++run) {
+        const auto start { std::chrono::steady_clock::now() };
+        if(std::system(command.c_str()) != 0) {
+            return -1.0;
+        }
+        const auto end { std::chrono::steady_clock::now() };
+        const double elapsed { std::chrono::duration<double, std::milli>(end - start).count() };
+        best = run == 0? elapsed: std::min(best, elapsed);
+    }
+    return best;
+}
+
+int main() {
+    const char* compilerVariable { std::getenv("CXX") };
+    const std::string compiler { compilerVariable? compilerVariable: "c++" };
+    const std::filesystem::path directory { std::filesystem::temp_directory_path() };
+
+    std::cout << "Compile time (" << compiler << " -fsyntax-only, best of 3) by number of handlers: \n";
+    for(const int handlerCount: { 4, 16, 32, 64 }) {
+        const double exclusiveTime {
+            timeCompilation(compiler, directory / "ExclusiveDispatch.cpp", generateExclusive(handlerCount))
+        };
+        const double rankedTime {
+            timeCompilation(compiler, directory / "RankedDispatch.cpp", generateRanked(handlerCount))
+        };
+        std::cout << "\t" << handlerCount << " handlers: exclusive " << exclusiveTime << "ms, ranked "
+            << rankedTime << "ms" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ *   Demonstrates an open-ended alternative to the mutually exclusive
+ * specializations in SingleSubclassSpecificSharedPtrFunctionSpecializations.cpp.
+ *
+ *   Each handler for shared pointer types is a specialization of a handler
+ * template at some numbered priority. For a given type, the handler with
+ * the highest priority that accepts it is used. Handlers therefore need
+ * not exclude each other, and adding one (at an unused priority) never
+ * requires editing the generic case or any other handler.
+ *
+ *   NOTE: two handlers at the *same* priority must not both accept a type;
+ * leave gaps between priorities so that new handlers can go in between.
+ * Priorities run from 0 to kMaxPrintPriority
+ */
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+class Base {};
+class OtherBase {};
+
+// highest priority a shared pointer print handler may have
+constexpr int kMaxPrintPriority { 32 };
+
+template <int Priority>
+struct PrintPrioritySlot {};
+
+template <int Priority>
+struct CheckPrintPriority {
+    static_assert(
+        Priority >= 0 && Priority <= kMaxPrintPriority,
+        "Shared pointer print handler priorities must be between 0 and kMaxPrintPriority"
+    );
+    using type = PrintPrioritySlot<Priority>;
+};
+
+// Handlers name their priority through this, so that one declared above
+// kMaxPrintPriority, where the walk below would never reach it, fails to
+// compile rather than being silently ignored
+template <int Priority>
+using PrintPriority = typename CheckPrintPriority<Priority>::type;
+
+// Priorities without a handler for T are empty slots that accept nothing
+template <typename TPriority, typename T, typename Enable=void>
+struct SharedPtrPrint {
+    static constexpr bool kAccepts { false };
+};
+
+// Walks down from the highest priority, inheriting from the first handler
+// that accepts T. Only the slots visited on the way are instantiated
+template <typename T, int Priority=kMaxPrintPriority>
+struct SelectSharedPtrPrint: std::conditional<
+    SharedPtrPrint<PrintPriority<Priority>, T>::kAccepts,
+    SharedPtrPrint<PrintPriority<Priority>, T>,
+    SelectSharedPtrPrint<T, Priority - 1>
+>::type {};
+
+template <typename T>
+struct SelectSharedPtrPrint<T, -1> {
+    static_assert(!std::is_same<T, T>::value, "No shared pointer print handler accepts this type");
+};
+
+class A {
+    template <typename T>
+    struct MyPrint;
+public:
+
+    template <typename T>
+    static void print() {
+        // we wrap print in a struct to allow partial specializations.
+        MyPrint<T>::print();
+    }
+
+private:
+    // template for non-shared_ptr types
+    template <typename T>
+    struct MyPrint {
+        static void print() {
+            std::cout << "A::print<T>: " << T::getName() << std::endl;
+        }
+    };
+
+    // partial specialization for shared_ptr types, which defers to the
+    // highest priority handler
+    template <typename T>
+    struct MyPrint<std::shared_ptr<T>>: SelectSharedPtrPrint<T> {};
+};
+
+// Generic shared pointer handler, at the lowest priority so that every
+// other handler is preferred to it
+template <typename T>
+struct SharedPtrPrint<PrintPriority<0>, T> {
+    static constexpr bool kAccepts { true };
+    static void print() {
+        std::cout << "(Generic)A::print<std::shared_ptr<T>>: " << T::getName() << std::endl;
+    }
+};
+
+// Handler for types that inherit from Base
+template <typename T>
+struct SharedPtrPrint<PrintPriority<10>, T, typename std::enable_if<std::is_base_of<Base, T>::value>::type> {
+    static constexpr bool kAccepts { true };
+    static void print() {
+        std::cout << "(Base handler)A::print<std::shared_ptr<T>>: " << T::getName() << std::endl;
+    }
+};
+
+// Handler for types that inherit from OtherBase, added without touching
+// the handlers above. Takes precedence over the Base handler for types
+// that inherit from both
+template <typename T>
+struct SharedPtrPrint<PrintPriority<20>, T, typename std::enable_if<std::is_base_of<OtherBase, T>::value>::type> {
+    static constexpr bool kAccepts { true };
+    static void print() {
+        std::cout << "(OtherBase handler)A::print<std::shared_ptr<T>>: " << T::getName() << std::endl;
+    }
+};
+
+class B: public Base {
+public:
+    static std::string getName() { return "B"; }
+};
+
+class C {
+public:
+    static std::string getName() { return "C"; }
+};
+
+class F: public Base, public OtherBase {
+public:
+    static std::string getName() { return "F"; }
+};
+
+class G: public OtherBase {
+public:
+    static std::string getName() { return "G"; }
+};
+
+int main() {
+    // regular old template function call
+    A::print<B>();
+
+    // regular old template function call
+    A::print<C>();
+
+    // Base handler
+    A::print<std::shared_ptr<B>>();
+
+    // generic handler
+    A::print<std::shared_ptr<C>>();
+
+    // both the Base and OtherBase handlers accept F; OtherBase's has
+    // the higher priority
+    A::print<std::shared_ptr<F>>();
+
+    // OtherBase handler
+    A::print<std::shared_ptr<G>>();
+
+    return 0;
+}
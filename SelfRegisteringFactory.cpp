@@ -6,6 +6,19 @@
  *   Creating a new factory method simply requires the creation of 
  * a ResourceFactoryMethod subclass; the static registrator takes care
  * of making it visible to the top level Resource system
+ * 
+ *   Registrators do as little as possible before main: each one only
+ * queues a record of function pointers. The registry itself is built in
+ * a single sorted pass the first time the ResourceDatabase is accessed
+ * 
+ *   In debug builds (or whenever compiled with RESOURCE_INSTRUMENTATION=1),
+ * every factory method records how often it was called, how long it took,
+ * and how much it allocated; see ResourceDatabase::getStatistics(). Release
+ * builds (NDEBUG) leave it out, and with it the replaced global operator new
+ * 
+ *   Resources that support serialization can be saved to a snapshot file
+ * and reconstructed from it on later launches, skipping their factory
+ * methods; see ResourceDatabase::loadSnapshot()
  */
 
 #include <memory>
@@ -13,14 +26,137 @@
 #include <vector>
 #include <tuple>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <type_traits>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <fstream>
+#include <filesystem>
 #include <iostream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// on by default in debug builds only; -DRESOURCE_INSTRUMENTATION=0 or 1
+// overrides that either way
+#ifndef RESOURCE_INSTRUMENTATION
+#ifdef NDEBUG
+#define RESOURCE_INSTRUMENTATION 0
+#else
+#define RESOURCE_INSTRUMENTATION 1
+#endif
+#endif
+
+#if RESOURCE_INSTRUMENTATION
+// Bytes allocated through operator new by each thread, so that factory
+// methods can be charged for what they allocate while they run
+thread_local std::size_t tAllocatedBytes { 0 };
+
+void* operator new(std::size_t size) {
+    tAllocatedBytes += size;
+    if(void* pMemory = std::malloc(size? size: 1)) {
+        return pMemory;
+    }
+    throw std::bad_alloc{};
+}
+
+// Kept out of line: once inlined, GCC sees free() called on memory from
+// operator new and reports it as a mismatch (-Wmismatched-new-delete)
+[[gnu::noinline]] void operator delete(void* pMemory) noexcept {
+    std::free(pMemory);
+}
+
+[[gnu::noinline]] void operator delete(void* pMemory, std::size_t) noexcept {
+    std::free(pMemory);
+}
+
+// Call durations counted in fixed buckets, a quarter of a power of two of
+// nanoseconds wide, so that it takes the same space however many calls
+// are recorded. Percentiles are read back to within 25%
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds duration) {
+        const std::uint64_t nanoseconds { static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0)) };
+        ++mBuckets[getBucket(nanoseconds)];
+        ++mCount;
+        mTotal += duration;
+    }
+
+    std::size_t getCount() const { return mCount; }
+    std::chrono::nanoseconds getTotal() const { return mTotal; }
+
+    // Nearest rank percentile, as the upper bound of the bucket it falls in
+    std::chrono::nanoseconds getPercentile(std::size_t percent) const {
+        const std::size_t rank { std::max<std::size_t>((percent * mCount + 99) / 100, 1) };
+        std::size_t seen { 0 };
+        for(std::size_t bucket{0}; bucket < mBuckets.size(); ++bucket) {
+            seen += mBuckets[bucket];
+            if(seen >= rank) {
+                return getBucketUpperBound(bucket);
+            }
+        }
+        return std::chrono::nanoseconds{ 0 };
+    }
+
+private:
+    static constexpr std::size_t kSubBuckets { 4 };
+
+    // Values below kSubBuckets have a bucket each. Above that, each power
+    // of two is split into kSubBuckets by the two bits below its top bit
+    static std::size_t getBucket(std::uint64_t nanoseconds) {
+        if(nanoseconds < kSubBuckets) {
+            return static_cast<std::size_t>(nanoseconds);
+        }
+        std::size_t topBit { 2 };
+        while(nanoseconds >> (topBit + 1)) {
+            ++topBit;
+        }
+        return (topBit - 1) * kSubBuckets + ((nanoseconds >> (topBit - 2)) & (kSubBuckets - 1));
+    }
+
+    static std::chrono::nanoseconds getBucketUpperBound(std::size_t bucket) {
+        if(bucket < kSubBuckets) {
+            return std::chrono::nanoseconds{ static_cast<std::int64_t>(bucket) };
+        }
+        const std::size_t topBit { bucket / kSubBuckets + 1 };
+        // the top power of two runs past what nanoseconds can hold
+        if(topBit >= 63) {
+            return std::chrono::nanoseconds::max();
+        }
+        const std::uint64_t nextBucketStart { (kSubBuckets + bucket % kSubBuckets + 1) << (topBit - 2) };
+        return std::chrono::nanoseconds{ static_cast<std::int64_t>(nextBucketStart - 1) };
+    }
+
+    std::array<std::size_t, 64 * kSubBuckets> mBuckets {};
+    std::size_t mCount { 0 };
+    std::chrono::nanoseconds mTotal { 0 };
+};
+#endif
+
 // forces implementation of static function RegisterSelf, called here.
 template<typename TRegisterable>
 class Registrator {
 public:
     Registrator() {
-        std::cout << "Inside registrator ctor" << std::endl;
         TRegisterable::registerSelf();
     }
     void emptyFunc() {
@@ -33,26 +169,308 @@ public:
 };
 
 class IResourceFactoryMethod;
+class IResourceFactory;
+
+// Hands a released resource back to the factory that made it, which may
+// keep it for reuse. Resources without a factory are simply deleted.
+//
+// NOTE: factories are owned by the ResourceDatabase singleton, so resources
+// must not outlive it (e.g. by being held in other static objects)
+struct ResourceDeleter {
+    void operator()(IResource* pResource) const;
+
+    IResourceFactory* mFactory { nullptr };
+};
+
+template <typename TResource=IResource>
+using ResourcePtr = std::unique_ptr<TResource, ResourceDeleter>;
 
 class IResourceFactory {
 public:
     virtual ~IResourceFactory()=default;
+
+    // Called in place of delete for resources this factory handed out
+    virtual void recycle(IResource* pResource) { delete pResource; }
+
+    // Snapshot support. Factories for resource types that can't be
+    // serialized leave these as they are
+    virtual bool serialize(const IResource&, std::string&) const { return false; }
+    virtual ResourcePtr<> deserialize(std::string_view) { return nullptr; }
+
     std::map<std::string, std::unique_ptr<IResourceFactoryMethod>> mFactoryMethods {};
 };
 
+inline void ResourceDeleter::operator()(IResource* pResource) const {
+    if(mFactory) { mFactory->recycle(pResource); }
+    else { delete pResource; }
+}
+
 class IResourceFactoryMethod {
 public:
     virtual ~IResourceFactoryMethod()=default;
-    virtual std::unique_ptr<IResource> createResource(std::string params) = 0;
+    virtual ResourcePtr<> createResource(std::string params) = 0;
+
+    // Methods that do slow work (I/O, heavy parsing) should override this
+    // so that asynchronous creation always runs them on a background
+    // thread. Cheap methods are run straight away on the calling thread
+    // when they have nothing to wait on
+    virtual bool isSlow() const { return false; }
+
+#if RESOURCE_INSTRUMENTATION
+    void recordCall(std::chrono::nanoseconds duration, std::size_t allocatedBytes) {
+        std::lock_guard<std::mutex> lock { mStatisticsMutex };
+        mCallDurations.record(duration);
+        mAllocatedBytes += allocatedBytes;
+    }
+
+private:
+    mutable std::mutex mStatisticsMutex {};
+    LatencyHistogram mCallDurations {};
+    std::size_t mAllocatedBytes { 0 };
+
+friend class ResourceDatabase;
+#endif
+};
+
+// A snapshot of one factory method's instrumentation
+struct ResourceMethodStatistics {
+    std::string mResource;
+    std::string mMethod;
+    std::size_t mCalls { 0 };
+    std::chrono::nanoseconds mTotalTime { 0 };
+    // accurate to within 25%; see LatencyHistogram
+    std::chrono::nanoseconds mP50 { 0 };
+    std::chrono::nanoseconds mP90 { 0 };
+    std::chrono::nanoseconds mP99 { 0 };
+    std::size_t mAllocatedBytes { 0 };
+};
+
+// The outcome of one asynchronous creation, shared by every handle to it.
+// Continuations registered before it resolves are run by whichever thread
+// resolves it; those registered after are run straight away
+class ResourceHandleState {
+public:
+    void resolve(std::shared_ptr<IResource> pResource) {
+        mPromise.set_value(std::move(pResource));
+        runContinuations();
+    }
+
+    void fail(std::exception_ptr error) {
+        mPromise.set_exception(error);
+        runContinuations();
+    }
+
+    void whenResolved(std::function<void()> continuation) {
+        {
+            std::lock_guard<std::mutex> lock { mMutex };
+            if(!mResolved) {
+                mContinuations.push_back(std::move(continuation));
+                return;
+            }
+        }
+        continuation();
+    }
+
+    const std::shared_future<std::shared_ptr<IResource>>& getFuture() const { return mFuture; }
+
+private:
+    void runContinuations() {
+        std::vector<std::function<void()>> continuations {};
+        {
+            std::lock_guard<std::mutex> lock { mMutex };
+            mResolved = true;
+            continuations.swap(mContinuations);
+        }
+        for(auto& continuation: continuations) {
+            continuation();
+        }
+    }
+
+    std::promise<std::shared_ptr<IResource>> mPromise {};
+    // unlike a future from std::async, this never blocks when the last
+    // handle lets go of it
+    std::shared_future<std::shared_ptr<IResource>> mFuture { mPromise.get_future().share() };
+    std::mutex mMutex {};
+    bool mResolved { false };
+    std::vector<std::function<void()>> mContinuations {};
 };
 
+// A handle to a resource that may still be under construction. Copies of
+// a handle refer to the same resource. Dropping every handle to a resource
+// doesn't wait for it, or stop it being created
+template <typename TResource>
+class ResourceHandle {
+public:
+    ResourceHandle() = default;
+
+    // blocks until the resource, and everything it depends on, is ready
+    std::shared_ptr<TResource> get() const {
+        return std::static_pointer_cast<TResource>(mState->getFuture().get());
+    }
+
+    bool isReady() const {
+        return mState->getFuture().wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+    }
+
+    // reinterprets the handle as referring to some other resource type;
+    // the caller is responsible for knowing the real type
+    template <typename TOther>
+    ResourceHandle<TOther> as() const {
+        return ResourceHandle<TOther>{ mState };
+    }
+
+private:
+    explicit ResourceHandle(std::shared_ptr<ResourceHandleState> pState): mState { std::move(pState) } {}
+
+    std::shared_ptr<ResourceHandleState> mState {};
+
+template <typename TOther>
+friend class ResourceHandle;
+friend class ResourceDatabase;
+};
+
+// A named resource description, which may name other descriptions that
+// must be created before it
+struct ResourceDescription {
+    std::string mName;
+    std::string mType;
+    std::string mMethod;
+    std::string mParams;
+    std::vector<std::string> mDependencies {};
+};
+
+// A factory or factory method waiting to be added to the registry.
+// Holds only function pointers, so that queueing one during static
+// initialization neither allocates strings nor constructs factories
+struct Registration {
+    std::string (*mGetResourceName)();
+    // null for factory registrations
+    std::string (*mGetMethodName)();
+    std::unique_ptr<IResourceFactory> (*mMakeFactory)();
+    std::unique_ptr<IResourceFactoryMethod> (*mMakeFactoryMethod)();
+};
+
+// A file of serialized resources, each keyed by the description (resource,
+// method, params) it was created from. The file is memory-mapped, and only
+// entry headers are read when it is opened.
+//
+// Layout, in native byte order, since a snapshot is a warm start cache for
+// the machine that wrote it rather than a portable format:
+//   header: magic (8 bytes), registry fingerprint (u64), entry count (u64)
+//   entry:  resource, method, params and payload lengths (u32 each),
+//           followed by those four byte strings
+class ResourceSnapshot {
+public:
+    using Key = std::tuple<std::string, std::string, std::string>;
+
+    ~ResourceSnapshot();
+    ResourceSnapshot(const ResourceSnapshot& other) = delete;
+    ResourceSnapshot& operator=(const ResourceSnapshot& other) = delete;
+
+    // Replaces path in one step, so it's safe to write over the file of a
+    // snapshot that is still open
+    static bool write(const std::string& path, std::uint64_t fingerprint, const std::map<Key, std::string>& payloads);
+
+    // null if the file is missing or malformed, or if it was written for
+    // a registry with a different fingerprint
+    static std::unique_ptr<ResourceSnapshot> open(const std::string& path, std::uint64_t fingerprint);
+
+    std::optional<std::string_view> find(const std::string& resource, const std::string& method, const std::string& params) const;
+
+    std::size_t getEntryCount() const { return mEntries.size(); }
+
+private:
+    ResourceSnapshot() = default;
+
+    static constexpr char kMagic[8] { 'R', 'E', 'S', 'S', 'N', 'A', 'P', '1' };
+
+    void* mMapping { nullptr };
+    std::size_t mMappingSize { 0 };
+    // views into the mapping
+    std::map<std::tuple<std::string_view, std::string_view, std::string_view>, std::string_view> mEntries {};
+};
+
+// A fixed set of threads running tasks from a shared queue, in the order
+// they were submitted
+class ResourceWorkerPool {
+public:
+    explicit ResourceWorkerPool(std::size_t threadCount) {
+        for(std::size_t i{0}; i < threadCount; ++i) {
+            mThreads.emplace_back([this]() { work(); });
+        }
+    }
+
+    // Finishes every task already submitted before returning
+    ~ResourceWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock { mMutex };
+            mStopping = true;
+        }
+        mTaskAvailable.notify_all();
+        for(auto& thread: mThreads) {
+            thread.join();
+        }
+    }
+
+    ResourceWorkerPool(const ResourceWorkerPool& other) = delete;
+    ResourceWorkerPool& operator=(const ResourceWorkerPool& other) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock { mMutex };
+            mTasks.push_back(std::move(task));
+        }
+        mTaskAvailable.notify_one();
+    }
+
+private:
+    void work() {
+        while(true) {
+            std::function<void()> task {};
+            {
+                std::unique_lock<std::mutex> lock { mMutex };
+                mTaskAvailable.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+                if(mTasks.empty()) {
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mMutex {};
+    std::condition_variable mTaskAvailable {};
+    std::deque<std::function<void()>> mTasks {};
+    bool mStopping { false };
+    std::vector<std::thread> mThreads {};
+};
+
+template<typename TResource, typename TDerivedMethod>
+class ResourceFactoryMethod;
+
 class ResourceDatabase {
 public:
     static ResourceDatabase& getInstance() {
+        // the registry is built by the constructor, which the static's
+        // initialization guard runs exactly once
         static ResourceDatabase resourceDatabase {};
+        // Registrations that arrive after that (e.g. from a library loaded
+        // later) are picked up here. They must not race with other threads
+        // using the registry
+        if(getHasPendingRegistrations().load(std::memory_order_acquire)) {
+            resourceDatabase.registerPending();
+        }
         return resourceDatabase;
     }
 
+    static void QueueRegistration(const Registration& registration) {
+        std::lock_guard<std::mutex> lock { getRegistrationMutex() };
+        getPendingRegistrations().push_back(registration);
+        getHasPendingRegistrations().store(true, std::memory_order_release);
+    }
+
     static void RegisterFactory (std::string name, std::unique_ptr<IResourceFactory> pFactory) {
         getInstance().mFactories[name] = std::move(pFactory);
     }
@@ -61,11 +479,135 @@ public:
         getInstance().mFactories[resource]->mFactoryMethods[method] = std::move(pFactoryMethod);
     }
 
+    // Creates a resource through the factory method registered under
+    // the given resource and method names
+    ResourcePtr<> create(const std::string& resource, const std::string& method, std::string params) {
+        if(ResourcePtr<> pResource = createFromSnapshot(resource, method, params)) {
+            return pResource;
+        }
+        ResourcePtr<> pResource { mFactories.at(resource)->mFactoryMethods.at(method)->createResource(params) };
+        recordForSnapshot(resource, method, params, *pResource);
+        return pResource;
+    }
+
+    // Creates a resource when both its type and factory method are known
+    // at compile time. Skips the registry lookup and the virtual call, and
+    // returns the concrete resource type
+    template <typename TResource, typename TMethod>
+    ResourcePtr<TResource> create(std::string params) {
+        static_assert(
+            std::is_base_of<ResourceFactoryMethod<TResource, TMethod>, TMethod>::value,
+            "TMethod must be a factory method for TResource"
+        );
+        if(!mSnapshot && !mRecordingSnapshot) {
+            return TMethod::getRegisteredInstance().createInstrumented(std::move(params));
+        }
+
+        // Snapshots are keyed by name, so names are only built when one is in use
+        const std::string resource { TResource::getName() };
+        const std::string method { TMethod::getName() };
+        if(ResourcePtr<> pSnapshotResource = createFromSnapshot(resource, method, params)) {
+            const ResourceDeleter deleter { pSnapshotResource.get_deleter() };
+            return ResourcePtr<TResource>{ static_cast<TResource*>(pSnapshotResource.release()), deleter };
+        }
+        ResourcePtr<TResource> pResource { TMethod::getRegisteredInstance().createInstrumented(params) };
+        recordForSnapshot(resource, method, params, *pResource);
+        return pResource;
+    }
+
+    // Maps a snapshot written by saveSnapshot(). Until another is loaded,
+    // synchronous and asynchronous creation look resources up in it before
+    // calling any factory method. Returns false, leaving creation to the
+    // factories, if the file is missing or malformed, or if the registered
+    // factories and methods have changed since it was written
+    bool loadSnapshot(const std::string& path);
+
+    // While recording, resources are serialized as they are created, for
+    // saveSnapshot()
+    void setSnapshotRecording(bool recording) { mRecordingSnapshot = recording; }
+
+    // May be given the path of the loaded snapshot, which stays usable
+    bool saveSnapshot(const std::string& path) const;
+
+    // Instrumentation for every registered factory method. Always empty
+    // without instrumentation (by default, in NDEBUG builds)
+    std::vector<ResourceMethodStatistics> getStatistics() const;
+
+    // Starts creating a resource and returns a handle to it immediately.
+    // The resource is only created once every handle in dependencies
+    // has resolved. Cheap methods with nothing to wait on run straight
+    // away on the calling thread; everything else runs on a small pool of
+    // worker threads
+    ResourceHandle<IResource> createAsync(
+        const std::string& resource,
+        const std::string& method,
+        const std::string& params,
+        std::vector<ResourceHandle<IResource>> dependencies={}
+    );
+
+    template <typename TResource>
+    ResourceHandle<TResource> createAsync(
+        const std::string& method,
+        const std::string& params,
+        std::vector<ResourceHandle<IResource>> dependencies={}
+    ) {
+        return createAsync(TResource::getName(), method, params, std::move(dependencies)).template as<TResource>();
+    }
+
+    // Starts creating every described resource in dependency order, so
+    // that each resource waits only on the resources it names. Returns a
+    // handle per description name
+    std::map<std::string, ResourceHandle<IResource>> loadAsync(
+        const std::vector<ResourceDescription>& descriptions
+    );
+
     std::map<std::string, std::unique_ptr<IResourceFactory>> mFactories {};    
 
 private:
-    ResourceDatabase() = default;
+    ResourceDatabase() {
+        registerPending();
+    }
 
+    // guarded by getRegistrationMutex()
+    static std::vector<Registration>& getPendingRegistrations() {
+        static std::vector<Registration> pendingRegistrations {};
+        return pendingRegistrations;
+    }
+
+    // lets getInstance() skip the mutex when nothing is queued
+    static std::atomic<bool>& getHasPendingRegistrations() {
+        static std::atomic<bool> hasPendingRegistrations { false };
+        return hasPendingRegistrations;
+    }
+
+    static std::mutex& getRegistrationMutex() {
+        static std::mutex registrationMutex {};
+        return registrationMutex;
+    }
+
+    void registerPending();
+
+    // identifies the set of registered factories and methods
+    std::uint64_t getRegistryFingerprint() const;
+
+    // null if there is no loaded snapshot, or it has no such resource
+    ResourcePtr<> createFromSnapshot(const std::string& resource, const std::string& method, const std::string& params);
+    void recordForSnapshot(const std::string& resource, const std::string& method, const std::string& params, const IResource& createdResource);
+
+    std::unique_ptr<ResourceSnapshot> mSnapshot {};
+    bool mRecordingSnapshot { false };
+    // asynchronously created resources are recorded from worker threads
+    mutable std::mutex mSnapshotPayloadsMutex {};
+    std::map<ResourceSnapshot::Key, std::string> mSnapshotPayloads {};
+
+    // started on first use, so that programs that never create anything
+    // asynchronously start no threads
+    ResourceWorkerPool& getWorkers();
+
+    // Declared last, so that it's destroyed first: workers finish their
+    // queued creations while the factories they use still exist
+    std::once_flag mWorkersStarted {};
+    std::unique_ptr<ResourceWorkerPool> mWorkers {};
 };
 
 template <typename TResource>
@@ -78,35 +620,174 @@ public:
         return TDerived::getName();
     }
     static void registerSelf() {
-        ResourceDatabase::RegisterFactory(getName(), std::make_unique<ResourceFactory<TDerived>>());
+        ResourceDatabase::QueueRegistration({
+            &TDerived::getName,
+            nullptr,
+            []() -> std::unique_ptr<IResourceFactory> {
+                std::unique_ptr<ResourceFactory<TDerived>> pFactory { std::make_unique<ResourceFactory<TDerived>>() };
+                ResourceFactory<TDerived>::s_registeredInstance = pFactory.get();
+                return pFactory;
+            },
+            nullptr
+        });
     }
+
 protected:
     Resource(int explicitlyInitializeMe) { s_registrator.emptyFunc(); }
 private:
     inline static Registrator<Resource<TDerived>> s_registrator = Registrator<Resource<TDerived>>();
 };
 
+struct ResourcePoolStatistics {
+    // resources handed out by acquire()
+    std::size_t mAcquired { 0 };
+    // acquired resources that came out of the pool rather than the allocator
+    std::size_t mReused { 0 };
+    // released resources kept in the pool
+    std::size_t mRecycled { 0 };
+    // released resources freed because the pool was full, and pooled
+    // resources freed because its capacity was lowered
+    std::size_t mFreed { 0 };
+    // resources presently waiting in the pool
+    std::size_t mPooled { 0 };
+};
+
+// Resource types support snapshots by providing
+//   void serialize(std::string& out) const;
+//   void deserialize(std::string_view data);
+// where deserialize() is called on a resource in its default state
+template <typename TResource, typename=void>
+struct IsSnapshotSerializable: std::false_type {};
+
+template <typename TResource>
+struct IsSnapshotSerializable<TResource, std::void_t<
+    decltype(std::declval<const TResource&>().serialize(std::declval<std::string&>())),
+    decltype(std::declval<TResource&>().deserialize(std::declval<std::string_view>()))
+>>: std::true_type {};
+
+// Resource types opt into pooling by being default constructible and
+// providing
+//   void reset();
+// which returns a released resource to its default state before reuse
+template <typename TResource, typename=void>
+struct IsPoolable: std::false_type {};
+
+template <typename TResource>
+struct IsPoolable<TResource, std::void_t<
+    decltype(std::declval<TResource&>().reset())
+>>: std::is_default_constructible<TResource> {};
+
+// Keeps a free list of released resources of its type, up to a capacity
+// which is 0 (i.e. no pooling) unless set otherwise. Resources of types
+// that aren't poolable are simply deleted when released
 template<typename TResource> 
 class ResourceFactory: public IResourceFactory {
 public:
-    ResourceFactory() {
-        std::cout << "Output of ctor" << std::endl;
+    ResourceFactory() = default;
+
+    // the instance owned by the ResourceDatabase
+    static ResourceFactory& getRegisteredInstance() {
+        ResourceDatabase::getInstance();
+        return *s_registeredInstance;
+    }
+
+    // A resource in its default state, reused from the pool if possible
+    ResourcePtr<TResource> acquire();
+
+    void recycle(IResource* pResource) override;
+
+    bool serialize(const IResource& resource, std::string& out) const override {
+        if constexpr (IsSnapshotSerializable<TResource>::value) {
+            static_cast<const TResource&>(resource).serialize(out);
+            return true;
+        } else {
+            return false;
+        }
     }
+
+    ResourcePtr<> deserialize(std::string_view data) override {
+        if constexpr (IsSnapshotSerializable<TResource>::value) {
+            ResourcePtr<TResource> pResource { acquire() };
+            pResource->deserialize(data);
+            return pResource;
+        } else {
+            return nullptr;
+        }
+    }
+
+    // only for poolable resource types
+    void setPoolCapacity(std::size_t capacity);
+
+    ResourcePoolStatistics getPoolStatistics() const;
+
+private:
+    static inline ResourceFactory* s_registeredInstance { nullptr };
+
+    mutable std::mutex mPoolMutex {};
+    std::vector<std::unique_ptr<TResource>> mPool {};
+    std::size_t mPoolCapacity { 0 };
+    ResourcePoolStatistics mPoolStatistics {};
+
+friend class Resource<TResource>;
 };
 
+// Subclasses implement a non-virtual create(std::string params) returning
+// ResourcePtr<TResource>, which serves both the string keyed and the
+// typed creation paths
 template<typename TResource, typename TDerivedMethod>
 class ResourceFactoryMethod: public IResourceFactoryMethod {
 public:
     static void registerSelf() {
-        ResourceDatabase::RegisterFactoryMethod(TResource::getName(), TDerivedMethod::getName(), std::make_unique<TDerivedMethod>());
+        ResourceDatabase::QueueRegistration({
+            &TResource::getName,
+            &TDerivedMethod::getName,
+            nullptr,
+            []() -> std::unique_ptr<IResourceFactoryMethod> {
+                std::unique_ptr<TDerivedMethod> pMethod { std::make_unique<TDerivedMethod>() };
+                s_registeredInstance = pMethod.get();
+                return pMethod;
+            }
+        });
+    }
+
+    // the instance owned by the ResourceDatabase
+    static TDerivedMethod& getRegisteredInstance() {
+        // makes sure the registry, and so this method, has been built
+        ResourceDatabase::getInstance();
+        return *s_registeredInstance;
+    }
+
+    ResourcePtr<> createResource(std::string params) final {
+        return createInstrumented(std::move(params));
     }
+
+    // The derived method's create(), recorded by the instrumentation
+    // when it is compiled in
+    ResourcePtr<TResource> createInstrumented(std::string params) {
+#if RESOURCE_INSTRUMENTATION
+        const std::size_t allocatedBefore { tAllocatedBytes };
+        const auto start { std::chrono::steady_clock::now() };
+#endif
+        ResourcePtr<TResource> pResource { static_cast<TDerivedMethod*>(this)->create(std::move(params)) };
+#if RESOURCE_INSTRUMENTATION
+        recordCall(std::chrono::steady_clock::now() - start, tAllocatedBytes - allocatedBefore);
+#endif
+        return pResource;
+    }
+
 protected:
+    // Factory methods should get their resources here rather than
+    // allocating them, so that released resources can be reused
+    static ResourcePtr<TResource> acquireResource() {
+        return ResourceFactory<TResource>::getRegisteredInstance().acquire();
+    }
+
     ResourceFactoryMethod(int explicitlyInitializeMe) {
-        std::cout << "Output of factory method constructor" << std::endl;
         s_registrator.emptyFunc();
     }
 private:
     static inline Registrator<ResourceFactoryMethod<TResource, TDerivedMethod>> s_registrator = Registrator<ResourceFactoryMethod<TResource, TDerivedMethod>>{};
+    static inline TDerivedMethod* s_registeredInstance { nullptr };
 };
 
 // Specialization of the resource class, made automatically visible
@@ -116,6 +797,19 @@ public:
     StringResource(std::string params): Resource<StringResource>{0}, mResource {params} {}
     StringResource(): Resource<StringResource>{0} {}
 
+    // keeps the string's buffer for the next user of this resource
+    void reset() {
+        mResource.clear();
+    }
+
+    void serialize(std::string& out) const {
+        out += mResource;
+    }
+
+    void deserialize(std::string_view data) {
+        mResource.assign(data.data(), data.size());
+    }
+
     std::string mResource {};
     static std::string getName() {
         return "String";
@@ -124,7 +818,7 @@ public:
 
 // Definition of a factory method, automatically made visible to the 
 // factory for StringResources
-class StringResourceFromString: public ResourceFactoryMethod<StringResource, StringResourceFromString> {
+class StringResourceFromString final: public ResourceFactoryMethod<StringResource, StringResourceFromString> {
 public:
     StringResourceFromString() 
     : ResourceFactoryMethod<StringResource, StringResourceFromString>{0} 
@@ -134,16 +828,16 @@ public:
         return "FromString";
     }
 
-    std::unique_ptr<IResource> createResource(std::string params) override {
+    ResourcePtr<StringResource> create(std::string params) {
         std::cout << "from FromString" << std::endl;
-        std::unique_ptr<StringResource> strRes { std::make_unique<StringResource>() };
+        ResourcePtr<StringResource> strRes { acquireResource() };
         strRes->mResource = params;
         return strRes;
     }
 };
 
 // Another factory method
-class StringResourceFromInt: public ResourceFactoryMethod<StringResource, StringResourceFromInt> {
+class StringResourceFromInt final: public ResourceFactoryMethod<StringResource, StringResourceFromInt> {
 public:
     StringResourceFromInt()
     : ResourceFactoryMethod<StringResource, StringResourceFromInt>{0}
@@ -152,9 +846,9 @@ public:
     static std::string getName() {
         return "FromInt";
     }
-    std::unique_ptr<IResource> createResource(std::string params) override {
+    ResourcePtr<StringResource> create(std::string params) {
         std::cout << "from FromInt" << std::endl;
-        std::unique_ptr<StringResource> strRes { std::make_unique<StringResource>() };
+        ResourcePtr<StringResource> strRes { acquireResource() };
         strRes->mResource = mStrings[std::stoi(params)];
         return strRes;
     }
@@ -162,6 +856,478 @@ public:
     const std::vector<std::string> mStrings {"Haha", "This should", "be fun.", "(I think)", "Woohooo"};
 };
 
+// A factory method standing in for one that reads from disk or the
+// network, and so asks to be run off the calling thread
+class StringResourceFromSlowString final: public ResourceFactoryMethod<StringResource, StringResourceFromSlowString> {
+public:
+    StringResourceFromSlowString()
+    : ResourceFactoryMethod<StringResource, StringResourceFromSlowString>{0}
+    {}
+
+    static std::string getName() {
+        return "FromSlowString";
+    }
+
+    bool isSlow() const override { return true; }
+
+    ResourcePtr<StringResource> create(std::string params) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        ResourcePtr<StringResource> strRes { acquireResource() };
+        strRes->mResource = params;
+        return strRes;
+    }
+};
+
+template <typename TResource>
+ResourcePtr<TResource> ResourceFactory<TResource>::acquire() {
+    std::unique_ptr<TResource> pResource {};
+    {
+        std::lock_guard<std::mutex> lock { mPoolMutex };
+        ++mPoolStatistics.mAcquired;
+        if(!mPool.empty()) {
+            pResource = std::move(mPool.back());
+            mPool.pop_back();
+            ++mPoolStatistics.mReused;
+            --mPoolStatistics.mPooled;
+        }
+    }
+    if(!pResource) {
+        pResource = std::make_unique<TResource>();
+    }
+    return ResourcePtr<TResource>{ pResource.release(), ResourceDeleter{ this } };
+}
+
+template <typename TResource>
+void ResourceFactory<TResource>::recycle(IResource* pResource) {
+    // declared before the locks, so that a resource that isn't pooled is
+    // destroyed after they're released
+    std::unique_ptr<TResource> pReleased { static_cast<TResource*>(pResource) };
+    if constexpr (IsPoolable<TResource>::value) {
+        {
+            std::lock_guard<std::mutex> lock { mPoolMutex };
+            if(mPool.size() >= mPoolCapacity) {
+                ++mPoolStatistics.mFreed;
+                return;
+            }
+        }
+
+        // reset outside the lock; it's the only part that may be slow. Other
+        // threads may fill the pool meanwhile, so capacity is checked again
+        pReleased->reset();
+
+        std::lock_guard<std::mutex> lock { mPoolMutex };
+        if(mPool.size() < mPoolCapacity) {
+            mPool.push_back(std::move(pReleased));
+            ++mPoolStatistics.mRecycled;
+            ++mPoolStatistics.mPooled;
+            return;
+        }
+        ++mPoolStatistics.mFreed;
+    }
+}
+
+template <typename TResource>
+void ResourceFactory<TResource>::setPoolCapacity(std::size_t capacity) {
+    static_assert(
+        IsPoolable<TResource>::value,
+        "Pooled resource types must be default constructible and provide reset()"
+    );
+    std::vector<std::unique_ptr<TResource>> dropped {};
+    std::lock_guard<std::mutex> lock { mPoolMutex };
+    mPoolCapacity = capacity;
+    if(mPool.size() > capacity) {
+        dropped.assign(std::make_move_iterator(mPool.begin() + capacity), std::make_move_iterator(mPool.end()));
+        mPool.resize(capacity);
+        mPoolStatistics.mFreed += dropped.size();
+        mPoolStatistics.mPooled = capacity;
+    }
+    mPool.reserve(capacity);
+}
+
+template <typename TResource>
+ResourcePoolStatistics ResourceFactory<TResource>::getPoolStatistics() const {
+    std::lock_guard<std::mutex> lock { mPoolMutex };
+    return mPoolStatistics;
+}
+
+inline void ResourceDatabase::registerPending() {
+    struct NamedRegistration {
+        std::string mResourceName;
+        std::string mMethodName;
+        const Registration* mRegistration;
+    };
+
+    // held throughout, so that two threads can't build at once
+    std::lock_guard<std::mutex> lock { getRegistrationMutex() };
+    std::vector<Registration> pending {};
+    pending.swap(getPendingRegistrations());
+    getHasPendingRegistrations().store(false, std::memory_order_relaxed);
+
+    std::vector<NamedRegistration> named {};
+    named.reserve(pending.size());
+    for(const auto& registration: pending) {
+        named.push_back({
+            registration.mGetResourceName(),
+            registration.mGetMethodName? registration.mGetMethodName(): std::string{},
+            &registration
+        });
+    }
+
+    // Sorted so that each factory precedes its methods, and so that
+    // every insertion below lands at the end of its map. A factory sorts
+    // before its methods since its method name is empty
+    std::sort(named.begin(), named.end(), [](const NamedRegistration& a, const NamedRegistration& b) {
+        return std::tie(a.mResourceName, a.mMethodName) < std::tie(b.mResourceName, b.mMethodName);
+    });
+
+    for(auto& entry: named) {
+        if(!entry.mRegistration->mGetMethodName) {
+            mFactories.emplace_hint(
+                mFactories.end(), std::move(entry.mResourceName), entry.mRegistration->mMakeFactory()
+            );
+            continue;
+        }
+
+        auto& factoryMethods { mFactories.at(entry.mResourceName)->mFactoryMethods };
+        factoryMethods.emplace_hint(
+            factoryMethods.end(), std::move(entry.mMethodName), entry.mRegistration->mMakeFactoryMethod()
+        );
+    }
+}
+
+inline std::vector<ResourceMethodStatistics> ResourceDatabase::getStatistics() const {
+    std::vector<ResourceMethodStatistics> statistics {};
+#if RESOURCE_INSTRUMENTATION
+    for(const auto& factoryPair: mFactories) {
+        for(const auto& methodPair: factoryPair.second->mFactoryMethods) {
+            const IResourceFactoryMethod& method { *methodPair.second };
+            LatencyHistogram durations {};
+            ResourceMethodStatistics methodStatistics { factoryPair.first, methodPair.first };
+            {
+                std::lock_guard<std::mutex> lock { method.mStatisticsMutex };
+                durations = method.mCallDurations;
+                methodStatistics.mAllocatedBytes = method.mAllocatedBytes;
+            }
+
+            methodStatistics.mCalls = durations.getCount();
+            methodStatistics.mTotalTime = durations.getTotal();
+            if(methodStatistics.mCalls > 0) {
+                methodStatistics.mP50 = durations.getPercentile(50);
+                methodStatistics.mP90 = durations.getPercentile(90);
+                methodStatistics.mP99 = durations.getPercentile(99);
+            }
+            statistics.push_back(methodStatistics);
+        }
+    }
+#endif
+    return statistics;
+}
+
+inline ResourceSnapshot::~ResourceSnapshot() {
+    if(mMapping) {
+        munmap(mMapping, mMappingSize);
+    }
+}
+
+inline bool ResourceSnapshot::write(const std::string& path, std::uint64_t fingerprint, const std::map<Key, std::string>& payloads) {
+    // Written beside the target, then renamed over it. Truncating the target
+    // in place would pull the pages out from under any snapshot already
+    // mapped from it (SIGBUS on the next lookup); renaming leaves that
+    // mapping on the old file until it's unmapped
+    const std::string temporaryPath { path + ".tmp" + std::to_string(getpid()) };
+    std::ofstream file { temporaryPath, std::ios::binary | std::ios::trunc };
+    if(!file) {
+        return false;
+    }
+
+    const std::uint64_t entryCount { payloads.size() };
+    file.write(kMagic, sizeof(kMagic));
+    file.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+    file.write(reinterpret_cast<const char*>(&entryCount), sizeof(entryCount));
+    for(const auto& entry: payloads) {
+        const std::string_view fields[4] {
+            std::get<0>(entry.first), std::get<1>(entry.first), std::get<2>(entry.first), entry.second
+        };
+        for(const auto& field: fields) {
+            const std::uint32_t length { static_cast<std::uint32_t>(field.size()) };
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        }
+        for(const auto& field: fields) {
+            file.write(field.data(), field.size());
+        }
+    }
+    file.close();
+
+    std::error_code error {};
+    if(file) {
+        std::filesystem::rename(temporaryPath, path, error);
+    }
+    if(!file || error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+inline std::unique_ptr<ResourceSnapshot> ResourceSnapshot::open(const std::string& path, std::uint64_t fingerprint) {
+    const int fileDescriptor { ::open(path.c_str(), O_RDONLY) };
+    if(fileDescriptor < 0) {
+        return nullptr;
+    }
+    struct stat fileStatus {};
+    if(fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0) {
+        close(fileDescriptor);
+        return nullptr;
+    }
+    const std::size_t size { static_cast<std::size_t>(fileStatus.st_size) };
+    void* mapping { mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0) };
+    // the mapping stays valid after the file is closed
+    close(fileDescriptor);
+    if(mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<ResourceSnapshot> snapshot { new ResourceSnapshot{} };
+    snapshot->mMapping = mapping;
+    snapshot->mMappingSize = size;
+
+    const char* cursor { static_cast<const char*>(mapping) };
+    const char* const end { cursor + size };
+    auto readInto = [&cursor, end](void* pValue, std::size_t valueSize) {
+        if(static_cast<std::size_t>(end - cursor) < valueSize) { return false; }
+        std::memcpy(pValue, cursor, valueSize);
+        cursor += valueSize;
+        return true;
+    };
+
+    char magic[sizeof(kMagic)] {};
+    std::uint64_t writtenFingerprint {};
+    std::uint64_t entryCount {};
+    if(
+        !readInto(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0
+        || !readInto(&writtenFingerprint, sizeof(writtenFingerprint)) || writtenFingerprint != fingerprint
+        || !readInto(&entryCount, sizeof(entryCount))
+    ) {
+        return nullptr;
+    }
+
+    for(std::uint64_t i{0}; i < entryCount; ++i) {
+        std::uint32_t lengths[4] {};
+        if(!readInto(lengths, sizeof(lengths))) {
+            return nullptr;
+        }
+        std::string_view fields[4] {};
+        for(int field{0}; field < 4; ++field) {
+            if(static_cast<std::size_t>(end - cursor) < lengths[field]) {
+                return nullptr;
+            }
+            fields[field] = std::string_view{ cursor, lengths[field] };
+            cursor += lengths[field];
+        }
+        snapshot->mEntries[{fields[0], fields[1], fields[2]}] = fields[3];
+    }
+    return snapshot;
+}
+
+inline std::optional<std::string_view> ResourceSnapshot::find(const std::string& resource, const std::string& method, const std::string& params) const {
+    const auto entry { mEntries.find({resource, method, params}) };
+    if(entry == mEntries.end()) {
+        return std::nullopt;
+    }
+    return entry->second;
+}
+
+inline std::uint64_t ResourceDatabase::getRegistryFingerprint() const {
+    // FNV-1a over every resource and method name, in the registry's order
+    std::uint64_t hash { 14695981039346656037ull };
+    auto addToHash = [&hash](const std::string& name) {
+        // including the terminator keeps "ab"+"c" apart from "a"+"bc"
+        for(const char character: name) {
+            hash = (hash ^ static_cast<unsigned char>(character)) * 1099511628211ull;
+        }
+        hash = hash * 1099511628211ull;
+    };
+    for(const auto& factoryPair: mFactories) {
+        addToHash(factoryPair.first);
+        for(const auto& methodPair: factoryPair.second->mFactoryMethods) {
+            addToHash(methodPair.first);
+        }
+        addToHash("");
+    }
+    return hash;
+}
+
+inline bool ResourceDatabase::loadSnapshot(const std::string& path) {
+    mSnapshot = ResourceSnapshot::open(path, getRegistryFingerprint());
+    return mSnapshot != nullptr;
+}
+
+inline bool ResourceDatabase::saveSnapshot(const std::string& path) const {
+    std::lock_guard<std::mutex> lock { mSnapshotPayloadsMutex };
+    return ResourceSnapshot::write(path, getRegistryFingerprint(), mSnapshotPayloads);
+}
+
+inline ResourcePtr<> ResourceDatabase::createFromSnapshot(const std::string& resource, const std::string& method, const std::string& params) {
+    if(!mSnapshot) {
+        return nullptr;
+    }
+    const std::optional<std::string_view> payload { mSnapshot->find(resource, method, params) };
+    if(!payload) {
+        return nullptr;
+    }
+    ResourcePtr<> pResource { mFactories.at(resource)->deserialize(*payload) };
+    // keep snapshot hits in the next snapshot too
+    if(pResource && mRecordingSnapshot) {
+        std::lock_guard<std::mutex> lock { mSnapshotPayloadsMutex };
+        mSnapshotPayloads[{resource, method, params}] = std::string{ *payload };
+    }
+    return pResource;
+}
+
+inline void ResourceDatabase::recordForSnapshot(const std::string& resource, const std::string& method, const std::string& params, const IResource& createdResource) {
+    if(!mRecordingSnapshot) {
+        return;
+    }
+    std::string payload {};
+    if(mFactories.at(resource)->serialize(createdResource, payload)) {
+        std::lock_guard<std::mutex> lock { mSnapshotPayloadsMutex };
+        mSnapshotPayloads[{resource, method, params}] = std::move(payload);
+    }
+}
+
+inline ResourceWorkerPool& ResourceDatabase::getWorkers() {
+    std::call_once(mWorkersStarted, [this]() {
+        const unsigned int threadCount { std::clamp(std::thread::hardware_concurrency(), 2u, 8u) };
+        mWorkers = std::make_unique<ResourceWorkerPool>(threadCount);
+    });
+    return *mWorkers;
+}
+
+inline ResourceHandle<IResource> ResourceDatabase::createAsync(
+    const std::string& resource,
+    const std::string& method,
+    const std::string& params,
+    std::vector<ResourceHandle<IResource>> dependencies
+) {
+    std::shared_ptr<ResourceHandleState> pState { std::make_shared<ResourceHandleState>() };
+
+    // A resource found in the snapshot is ready straight away; it was only
+    // ordered after its dependencies so that they'd exist when it was made
+    if(ResourcePtr<> pSnapshotResource = createFromSnapshot(resource, method, params)) {
+        pState->resolve(std::move(pSnapshotResource));
+        return ResourceHandle<IResource>{ pState };
+    }
+
+    // Look the method up here, on the calling thread, so that an unknown
+    // resource or method is reported to the caller. Workers only ever read
+    // the registry
+    IResourceFactoryMethod* pMethod { mFactories.at(resource)->mFactoryMethods.at(method).get() };
+
+    // Only ever run once every dependency has resolved, so nothing here waits
+    auto createTask = [this, pMethod, resource, method, params, dependencies, pState]() {
+        try {
+            // get() rather than skipping the check, so that a failed
+            // dependency fails its dependents too
+            for(const auto& dependency: dependencies) {
+                dependency.get();
+            }
+            ResourcePtr<> pResource { pMethod->createResource(params) };
+            recordForSnapshot(resource, method, params, *pResource);
+            pState->resolve(std::move(pResource));
+        }
+        catch(...) {
+            pState->fail(std::current_exception());
+        }
+    };
+
+    // Cheap methods with nothing left to wait on are run here and now
+    const bool dependenciesReady {
+        std::all_of(dependencies.begin(), dependencies.end(), [](const ResourceHandle<IResource>& dependency) {
+            return dependency.isReady();
+        })
+    };
+    if(dependenciesReady) {
+        if(pMethod->isSlow()) {
+            getWorkers().submit(createTask);
+        }
+        else {
+            createTask();
+        }
+        return ResourceHandle<IResource>{ pState };
+    }
+
+    // Otherwise the last dependency to resolve submits it to the workers,
+    // rather than a thread waiting on each dependency in turn. It isn't run
+    // on the resolving thread itself, so that a long chain of cheap
+    // dependents can't recurse through it
+    std::shared_ptr<std::atomic<std::size_t>> pUnresolvedCount {
+        std::make_shared<std::atomic<std::size_t>>(dependencies.size())
+    };
+    for(const auto& dependency: dependencies) {
+        dependency.mState->whenResolved([this, pUnresolvedCount, createTask]() {
+            if(pUnresolvedCount->fetch_sub(1) == 1) {
+                getWorkers().submit(createTask);
+            }
+        });
+    }
+    return ResourceHandle<IResource>{ pState };
+}
+
+inline std::map<std::string, ResourceHandle<IResource>> ResourceDatabase::loadAsync(
+    const std::vector<ResourceDescription>& descriptions
+) {
+    std::map<std::string, const ResourceDescription*> descriptionsByName {};
+    for(const auto& description: descriptions) {
+        if(!descriptionsByName.insert({description.mName, &description}).second) {
+            throw std::invalid_argument{ "Duplicate resource description: " + description.mName };
+        }
+    }
+
+    // Kahn's algorithm: a description is handed to createAsync as soon as
+    // everything it depends on has been, so that each has handles for its
+    // dependencies. createAsync then starts it once they resolve
+    std::map<std::string, std::size_t> unlaunchedDependencyCounts {};
+    std::map<std::string, std::vector<const ResourceDescription*>> dependents {};
+    std::vector<const ResourceDescription*> launchable {};
+    for(const auto& description: descriptions) {
+        for(const auto& dependency: description.mDependencies) {
+            if(!descriptionsByName.count(dependency)) {
+                throw std::invalid_argument{ description.mName + " depends on unknown resource " + dependency };
+            }
+            dependents[dependency].push_back(&description);
+        }
+        unlaunchedDependencyCounts[description.mName] = description.mDependencies.size();
+        if(description.mDependencies.empty()) {
+            launchable.push_back(&description);
+        }
+    }
+
+    std::map<std::string, ResourceHandle<IResource>> handles {};
+    while(!launchable.empty()) {
+        const ResourceDescription* pDescription { launchable.back() };
+        launchable.pop_back();
+
+        std::vector<ResourceHandle<IResource>> dependencyHandles {};
+        for(const auto& dependency: pDescription->mDependencies) {
+            dependencyHandles.push_back(handles.at(dependency));
+        }
+        handles[pDescription->mName] = createAsync(
+            pDescription->mType, pDescription->mMethod, pDescription->mParams, std::move(dependencyHandles)
+        );
+
+        for(const ResourceDescription* pDependent: dependents[pDescription->mName]) {
+            if(--unlaunchedDependencyCounts[pDependent->mName] == 0) {
+                launchable.push_back(pDependent);
+            }
+        }
+    }
+
+    if(handles.size() != descriptions.size()) {
+        throw std::invalid_argument{ "Resource descriptions contain a dependency cycle" };
+    }
+    return handles;
+}
+
 int main() {
     std::cout << "In main\n";
 
@@ -174,6 +1340,23 @@ int main() {
     }
     std::cout << std::endl;
     
+    // Keep up to 4 released StringResources around for reuse
+    ResourceFactory<StringResource>::getRegisteredInstance().setPoolCapacity(4);
+
+    // Resources saved by a previous run are reconstructed from the snapshot
+    // rather than created by their factory methods, so on a second run the
+    // "from ..." lines below disappear
+    const std::string snapshotPath {
+        (std::filesystem::temp_directory_path() / "SelfRegisteringFactory.snapshot").string()
+    };
+    ResourceDatabase& resourceDatabase { ResourceDatabase::getInstance() };
+    if(resourceDatabase.loadSnapshot(snapshotPath)) {
+        std::cout << "Warm start from " << snapshotPath << "\n\n";
+    } else {
+        std::cout << "Cold start; no usable snapshot at " << snapshotPath << "\n\n";
+    }
+    resourceDatabase.setSnapshotRecording(true);
+
     using typeMethodParams = std::tuple<std::string, std::string, std::string>;
 
     // These tuples act as serialized resource descriptions; they could
@@ -190,16 +1373,86 @@ int main() {
         // It's the factory methods job to deserialize resource descriptions
         std::shared_ptr<StringResource> strResource { 
             std::static_pointer_cast<StringResource, IResource>(
-                ResourceDatabase::getInstance().mFactories[std::get<0>(description)]
-                    ->mFactoryMethods[std::get<1>(description)]
-                    ->createResource(
-                        std::get<2>(description)
-                    )
+                ResourceDatabase::getInstance().create(
+                    std::get<0>(description),
+                    std::get<1>(description),
+                    std::get<2>(description)
+                )
             )
         };
         std::cout << "\tresource description: " << std::get<0>(description) << ", " << std::get<1>(description) << ", " << std::get<2>(description) << "\n";
         std::cout << "\tcreated string: " << strResource->mResource << std::endl;
     }
+    std::cout << std::endl;
+
+    // The same kind of descriptions, but named, with dependencies between
+    // them. "slowA" and "slowB" load in parallel; "afterBoth" waits on both
+    std::vector<ResourceDescription> namedDescriptions {
+        {"slowA", "String", "FromSlowString", "loaded A"},
+        {"slowB", "String", "FromSlowString", "loaded B"},
+        {"afterBoth", "String", "FromInt", "2", {"slowA", "slowB"}},
+        {"afterA", "String", "FromString", "after A", {"slowA"}},
+    };
+
+    std::cout << "Printing asynchronously created resources: \n";
+    const auto loadStart { std::chrono::steady_clock::now() };
+    std::map<std::string, ResourceHandle<IResource>> handles {
+        ResourceDatabase::getInstance().loadAsync(namedDescriptions)
+    };
+    for(const auto& description: namedDescriptions) {
+        // handles are untyped when created from descriptions, but resolve
+        // straight to the resource type once the caller names it
+        std::shared_ptr<StringResource> strResource { handles.at(description.mName).as<StringResource>().get() };
+        std::cout << "\t" << description.mName << ": " << strResource->mResource << "\n";
+    }
+    std::cout << "\tloaded in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - loadStart
+    ).count() << "ms" << std::endl;
+
+    // When the type is known at the call site, the handle is typed from the start
+    ResourceHandle<StringResource> typedHandle {
+        ResourceDatabase::getInstance().createAsync<StringResource>("FromSlowString", "typed handle")
+    };
+    std::cout << "\ttyped handle: " << typedHandle.get()->mResource << std::endl;
+    std::cout << std::endl;
+
+    // When the type and method are both known at compile time, no lookup
+    // or cast is needed at all
+    std::cout << "Printing a resource created through the typed path: \n";
+    ResourcePtr<StringResource> typedResource {
+        ResourceDatabase::getInstance().create<StringResource, StringResourceFromInt>("0")
+    };
+    std::cout << "\tcreated string: " << typedResource->mResource << std::endl;
+    typedResource.reset();
+    std::cout << std::endl;
+
+    // Every StringResource in this demo was released right after use, so
+    // with pooling enabled most were reused rather than reallocated
+    const ResourcePoolStatistics poolStatistics {
+        ResourceFactory<StringResource>::getRegisteredInstance().getPoolStatistics()
+    };
+    std::cout << "Printing StringResource pool statistics: \n";
+    std::cout << "\tacquired: " << poolStatistics.mAcquired
+        << ", reused: " << poolStatistics.mReused
+        << ", recycled: " << poolStatistics.mRecycled
+        << ", freed: " << poolStatistics.mFreed
+        << ", pooled: " << poolStatistics.mPooled << std::endl;
+    std::cout << std::endl;
+
+    if(resourceDatabase.saveSnapshot(snapshotPath)) {
+        std::cout << "Saved snapshot to " << snapshotPath << "\n\n";
+    }
+
+    std::cout << "Printing factory method statistics: \n";
+    for(const ResourceMethodStatistics& methodStatistics: ResourceDatabase::getInstance().getStatistics()) {
+        std::cout << "\t" << methodStatistics.mResource << "::" << methodStatistics.mMethod
+            << ": calls " << methodStatistics.mCalls
+            << ", total " << std::chrono::duration_cast<std::chrono::microseconds>(methodStatistics.mTotalTime).count() << "us"
+            << ", p50 " << std::chrono::duration_cast<std::chrono::microseconds>(methodStatistics.mP50).count() << "us"
+            << ", p90 " << std::chrono::duration_cast<std::chrono::microseconds>(methodStatistics.mP90).count() << "us"
+            << ", p99 " << std::chrono::duration_cast<std::chrono::microseconds>(methodStatistics.mP99).count() << "us"
+            << ", allocated " << methodStatistics.mAllocatedBytes << "B\n";
+    }
 
     return 0;
 }
@@ -0,0 +1,276 @@
+/**
+ *   Measures the startup cost of self-registering resource types, against
+ * the number of registered types, for two ways of registering them:
+ *
+ *   - eager: the original registrators of SelfRegisteringFactory.cpp,
+ *     each of which logs through std::cout with std::endl, constructs its
+ *     factory or factory method, and inserts it into the registry maps
+ *     during static initialization
+ *   - eager without logging: the same, minus the logging
+ *   - queued: the registrators SelfRegisteringFactory.cpp has now, which
+ *     only queue a record of function pointers during static
+ *     initialization, leaving the registry to be built in one sorted pass
+ *     on first access. These don't log either
+ *
+ *   For each type count, a program is generated per strategy, declaring
+ * that many resource types with two factory methods each. The queued
+ * program includes SelfRegisteringFactory.cpp itself, so its registrators
+ * are the real ones; the eager program carries a copy of the original
+ * registration code, plus a type standing in for the demo's own, which
+ * the queued program registers too. The queued program is compiled with
+ * RESOURCE_INSTRUMENTATION=0, as the instrumentation has no counterpart
+ * in the others. Each program's main only makes the first registry
+ * access, so that all of them have built the same registry when they exit.
+ *
+ *   The path to SelfRegisteringFactory.cpp can be given as the first
+ * argument; it defaults to the one beside this file.
+ *
+ *   The programs are compiled with $CXX (or c++ if it isn't set), then run
+ * with their output sent to a file, and timed from launch to exit. An
+ * empty program is timed the same way, to show the cost of just starting
+ * a process. Logging to a terminal rather than a file would make the
+ * logging programs slower still.
+ *
+ *   NOTE: all that queueing saves over the original registrators is their
+ * logging, which flushes once per line. Measured against eager
+ * registration without logging, the single sorted pass has been no
+ * faster end to end, and somewhat slower at a few hundred types
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Registration code as it was before registrations were queued, with its
+// logging behind LOG so that it can also be measured without it
+const char* const kEagerRegistration { R"(
+#include <memory>
+#include <string>
+#include <map>
+#include <iostream>
+
+template<typename TRegisterable>
+class Registrator {
+public:
+    Registrator() {
+        LOG("Inside registrator ctor");
+        TRegisterable::registerSelf();
+    }
+    void emptyFunc() {
+    }
+};
+
+class IResource {
+public:
+    virtual ~IResource()=default;
+};
+
+class IResourceFactoryMethod;
+
+class IResourceFactory {
+public:
+    virtual ~IResourceFactory()=default;
+    std::map<std::string, std::unique_ptr<IResourceFactoryMethod>> mFactoryMethods {};
+};
+
+class IResourceFactoryMethod {
+public:
+    virtual ~IResourceFactoryMethod()=default;
+    virtual std::unique_ptr<IResource> createResource(std::string params) = 0;
+};
+
+class ResourceDatabase {
+public:
+    static ResourceDatabase& getInstance() {
+        static ResourceDatabase resourceDatabase {};
+        return resourceDatabase;
+    }
+    static void RegisterFactory (std::string name, std::unique_ptr<IResourceFactory> pFactory) {
+        getInstance().mFactories[name] = std::move(pFactory);
+    }
+    static void RegisterFactoryMethod (std::string resource, std::string method, std::unique_ptr<IResourceFactoryMethod> pFactoryMethod) {
+        getInstance().mFactories[resource]->mFactoryMethods[method] = std::move(pFactoryMethod);
+    }
+    std::map<std::string, std::unique_ptr<IResourceFactory>> mFactories {};
+private:
+    ResourceDatabase() = default;
+};
+
+template <typename TResource>
+class ResourceFactory;
+
+template <typename TDerived>
+class Resource: public IResource {
+public:
+    static void registerSelf() {
+        ResourceDatabase::RegisterFactory(TDerived::getName(), std::make_unique<ResourceFactory<TDerived>>());
+    }
+protected:
+    Resource(int) { s_registrator.emptyFunc(); }
+private:
+    inline static Registrator<Resource<TDerived>> s_registrator = Registrator<Resource<TDerived>>();
+};
+
+template<typename TResource>
+class ResourceFactory: public IResourceFactory {
+public:
+    ResourceFactory() {
+        LOG("Output of ctor");
+    }
+};
+
+template<typename TResource, typename TDerivedMethod>
+class ResourceFactoryMethod: public IResourceFactoryMethod {
+public:
+    static void registerSelf() {
+        ResourceDatabase::RegisterFactoryMethod(TResource::getName(), TDerivedMethod::getName(), std::make_unique<TDerivedMethod>());
+    }
+protected:
+    ResourceFactoryMethod(int) {
+        LOG("Output of factory method constructor");
+        s_registrator.emptyFunc();
+    }
+private:
+    static inline Registrator<ResourceFactoryMethod<TResource, TDerivedMethod>> s_registrator = Registrator<ResourceFactoryMethod<TResource, TDerivedMethod>>{};
+};
+)" };
+
+void generateEagerType(std::ostringstream& source, const std::string& name, std::initializer_list<const char*> methods) {
+    source << "class " << name << ": public Resource<" << name << "> {\n"
+        << "public:\n"
+        << "    " << name << "(): Resource<" << name << ">{0} {}\n"
+        << "    static std::string getName() { return \"" << name << "\"; }\n"
+        << "};\n";
+    for(const char* method: methods) {
+        source << "class " << name << method << ": public ResourceFactoryMethod<" << name << ", " << name << method << "> {\n"
+            << "public:\n"
+            << "    " << name << method << "(): ResourceFactoryMethod<" << name << ", " << name << method << ">{0} {}\n"
+            << "    static std::string getName() { return \"" << method << "\"; }\n"
+            << "    std::unique_ptr<IResource> createResource(std::string) override { return std::make_unique<" << name << ">(); }\n"
+            << "};\n";
+    }
+}
+
+std::string generateEager(int typeCount, bool logging) {
+    std::ostringstream source {};
+    source << (logging? "#define LOG(message) std::cout << message << std::endl\n": "#define LOG(message)\n")
+        << kEagerRegistration << "\n";
+    for(int type{0}; type < typeCount; ++type) {
+        generateEagerType(source, "Resource" + std::to_string(type), { "FromA", "FromB" });
+    }
+    // stands in for the demo's resource type and methods, which the queued
+    // program registers too
+    generateEagerType(source, "String", { "FromString", "FromInt", "FromSlowString" });
+    source << "\nint main() {\n"
+        << "    return ResourceDatabase::getInstance().mFactories.empty();\n"
+        << "}\n";
+    return source.str();
+}
+
+std::string generateQueued(int typeCount, const std::filesystem::path& selfRegisteringFactory) {
+    std::ostringstream source {};
+    source << "#define main selfRegisteringFactoryDemo\n"
+        << "#include \"" << selfRegisteringFactory.string() << "\"\n"
+        << "#undef main\n\n";
+    for(int type{0}; type < typeCount; ++type) {
+        const std::string name { "Resource" + std::to_string(type) };
+        source << "class " << name << ": public Resource<" << name << "> {\n"
+            << "public:\n"
+            << "    " << name << "(): Resource<" << name << ">{0} {}\n"
+            << "    static std::string getName() { return \"" << name << "\"; }\n"
+            << "};\n";
+        for(const char* method: { "FromA", "FromB" }) {
+            source << "class " << name << method << " final: public ResourceFactoryMethod<" << name << ", " << name << method << "> {\n"
+                << "public:\n"
+                << "    " << name << method << "(): ResourceFactoryMethod<" << name << ", " << name << method << ">{0} {}\n"
+                << "    static std::string getName() { return \"" << method << "\"; }\n"
+                << "    ResourcePtr<" << name << "> create(std::string) { return acquireResource(); }\n"
+                << "};\n";
+        }
+    }
+    source << "\nint main() {\n"
+        << "    return ResourceDatabase::getInstance().mFactories.empty();\n"
+        << "}\n";
+    return source.str();
+}
+
+bool compile(const std::string& compiler, const std::filesystem::path& sourcePath, const std::string& source, const std::filesystem::path& binaryPath) {
+    std::ofstream { sourcePath } << source;
+    // without instrumentation, SelfRegisteringFactory.cpp doesn't replace
+    // operator new, so the queued program allocates the way the others do
+    const std::string command {
+        compiler + " -std=c++17 -O2 -pthread -w -DRESOURCE_INSTRUMENTATION=0 " + sourcePath.string() + " -o " + binaryPath.string()
+    };
+    return std::system(command.c_str()) == 0;
+}
+
+// Best of a few runs, from launch to exit, in milliseconds
+double timeRun(const std::filesystem::path& binaryPath, const std::filesystem::path& logPath) {
+    const std::string command { binaryPath.string() + " > " + logPath.string() };
+
+    constexpr int runs { 10 };
+    double best {};
+    for(int run{0}; run < runs; ++run) {
+        const auto start { std::chrono::steady_clock::now() };
+        if(std::system(command.c_str()) != 0) {
+            return -1.0;
+        }
+        const auto end { std::chrono::steady_clock::now() };
+        const double elapsed { std::chrono::duration<double, std::milli>(end - start).count() };
+        best = run == 0? elapsed: std::min(best, elapsed);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    const char* compilerVariable { std::getenv("CXX") };
+    const std::string compiler { compilerVariable? compilerVariable: "c++" };
+    const std::filesystem::path directory { std::filesystem::temp_directory_path() };
+
+    // __FILE__ is only as absolute as the path this was compiled from, so
+    // the path can also be given as the first argument
+    const std::filesystem::path selfRegisteringFactory {
+        std::filesystem::absolute(argc > 1?
+            std::filesystem::path{ argv[1] }:
+            std::filesystem::path{ __FILE__ }.parent_path() / "SelfRegisteringFactory.cpp"
+        )
+    };
+    if(!std::filesystem::exists(selfRegisteringFactory)) {
+        std::cerr << "No " << selfRegisteringFactory << "; pass the path to SelfRegisteringFactory.cpp as the first argument" << std::endl;
+        return 1;
+    }
+    const std::filesystem::path logPath { directory / "StaticRegistrationBenchmark.log" };
+
+    const std::filesystem::path emptyBinary { directory / "EmptyStartup" };
+    if(!compile(compiler, directory / "EmptyStartup.cpp", "int main() { return 0; }\n", emptyBinary)) {
+        std::cerr << "Could not compile with " << compiler << std::endl;
+        return 1;
+    }
+    std::cout << "Startup time, launch to exit (best of 10; output sent to a file): \n";
+    std::cout << "\tempty program: " << timeRun(emptyBinary, logPath) << "ms" << std::endl;
+
+    for(const int typeCount: { 16, 64, 256 }) {
+        const std::filesystem::path eagerBinary { directory / "EagerRegistration" };
+        const std::filesystem::path silentBinary { directory / "SilentEagerRegistration" };
+        const std::filesystem::path queuedBinary { directory / "QueuedRegistration" };
+        if(
+            !compile(compiler, directory / "EagerRegistration.cpp", generateEager(typeCount, true), eagerBinary)
+            || !compile(compiler, directory / "SilentEagerRegistration.cpp", generateEager(typeCount, false), silentBinary)
+            || !compile(compiler, directory / "QueuedRegistration.cpp", generateQueued(typeCount, selfRegisteringFactory), queuedBinary)
+        ) {
+            std::cerr << "Could not compile the generated programs for " << typeCount << " types" << std::endl;
+            return 1;
+        }
+        std::cout << "\t" << typeCount << " types (" << typeCount * 3 + 4 << " registrations): eager "
+            << timeRun(eagerBinary, logPath) << "ms, eager without logging " << timeRun(silentBinary, logPath)
+            << "ms, queued " << timeRun(queuedBinary, logPath) << "ms" << std::endl;
+    }
+
+    return 0;
+}
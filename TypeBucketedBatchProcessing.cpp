@@ -0,0 +1,236 @@
+/**
+ *   Demonstrates processing a heterogeneous collection of shared pointers
+ * to a base class one concrete type at a time. The collection is
+ * partitioned into a bucket per concrete type, and each bucket is then run
+ * through a handler chosen at compile time (using SFINAE, as in
+ * SingleSubclassSpecificSharedPtrFunctionSpecializations.cpp) in a single
+ * loop with no virtual calls.
+ *
+ *   main compares this against calling a virtual function per element,
+ * and against visiting a std::variant per element.
+ *
+ *   NOTE: buckets hold shared pointers, so it is the pointers that are
+ * contiguous, not the objects they point to
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+#include <vector>
+
+struct Totals {
+    double mSum {};
+};
+
+class Base {
+public:
+    virtual ~Base() = default;
+    virtual void update(Totals& totals) const = 0;
+};
+
+// Types with a weight that should scale their contribution
+class Weighted {};
+
+template <typename T, typename Enable=void>
+struct MyProcess;
+
+class B: public Base, public Weighted {
+public:
+    void update(Totals& totals) const override;
+    int mValue {};
+    double mWeight { 1.0 };
+};
+
+class C: public Base {
+public:
+    void update(Totals& totals) const override;
+    int mValue {};
+};
+
+class D: public Base, public Weighted {
+public:
+    void update(Totals& totals) const override;
+    int mValue {};
+    double mWeight { 1.0 };
+};
+
+// Handler for types that aren't weighted
+template <typename T, typename Enable>
+struct MyProcess {
+    static void processOne(const T& value, Totals& totals) {
+        totals.mSum += value.mValue;
+    }
+
+    static void process(const std::vector<std::shared_ptr<T>>& bucket, Totals& totals) {
+        for(const auto& pValue: bucket) {
+            processOne(*pValue, totals);
+        }
+    }
+};
+
+// Handler for weighted types. Will be preferred by the compiler for being
+// more specialized than the generic handler
+template <typename T>
+struct MyProcess<T, typename std::enable_if<std::is_base_of<Weighted, T>::value>::type> {
+    static void processOne(const T& value, Totals& totals) {
+        totals.mSum += value.mValue * value.mWeight;
+    }
+
+    static void process(const std::vector<std::shared_ptr<T>>& bucket, Totals& totals) {
+        for(const auto& pValue: bucket) {
+            processOne(*pValue, totals);
+        }
+    }
+};
+
+// the virtual overrides do exactly what their handlers do
+void B::update(Totals& totals) const { MyProcess<B>::processOne(*this, totals); }
+void C::update(Totals& totals) const { MyProcess<C>::processOne(*this, totals); }
+void D::update(Totals& totals) const { MyProcess<D>::processOne(*this, totals); }
+
+// A collection of shared pointers to TBase, partitioned into one bucket
+// per concrete type in TTypes. Elements whose concrete type isn't listed
+// (including types derived from a listed type) are set aside, to be
+// processed some other way. Null elements are skipped
+template <typename TBase, typename ...TTypes>
+class TypeBuckets {
+public:
+    explicit TypeBuckets(const std::vector<std::shared_ptr<TBase>>& collection) {
+        partition(collection, std::index_sequence_for<TTypes...>{});
+    }
+
+    // Calls bucketFunction once per bucket, with a
+    // const std::vector<std::shared_ptr<T>>& for each T in TTypes
+    template <typename TBucketFunction>
+    void forEachBucket(TBucketFunction&& bucketFunction) const {
+        std::apply([&bucketFunction](const auto& ...buckets) { (bucketFunction(buckets), ...); }, mBuckets);
+    }
+
+    const std::vector<std::shared_ptr<TBase>>& getUnbucketed() const { return mUnbucketed; }
+
+private:
+    template <std::size_t ...Indices>
+    void partition(const std::vector<std::shared_ptr<TBase>>& collection, std::index_sequence<Indices...>) {
+        for(const auto& pElement: collection) {
+            // typeid of a null pointer's target throws; there's nothing to process anyway
+            if(!pElement) {
+                continue;
+            }
+            const std::type_info& elementType { typeid(*pElement) };
+            // the matching type's bucket takes the element, ending the fold
+            const bool bucketed {(
+                (elementType == typeid(TTypes) && (
+                    std::get<Indices>(mBuckets).push_back(std::static_pointer_cast<TTypes>(pElement)), true
+                )) || ...
+            )};
+            if(!bucketed) {
+                mUnbucketed.push_back(pElement);
+            }
+        }
+    }
+
+    std::tuple<std::vector<std::shared_ptr<TTypes>>...> mBuckets {};
+    std::vector<std::shared_ptr<TBase>> mUnbucketed {};
+};
+
+template <typename TFunction>
+double timeMilliseconds(TFunction&& function) {
+    const auto start { std::chrono::steady_clock::now() };
+    function();
+    const auto end { std::chrono::steady_clock::now() };
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    constexpr int elementCount { 1000000 };
+    constexpr int repetitions { 10 };
+
+    // The same objects, held once through the base class and once in variants
+    using ElementVariant = std::variant<std::shared_ptr<B>, std::shared_ptr<C>, std::shared_ptr<D>>;
+    std::vector<std::shared_ptr<Base>> collection {};
+    std::vector<ElementVariant> variants {};
+    {
+        std::mt19937 generator { 42 };
+        std::uniform_int_distribution<int> typeDistribution { 0, 2 };
+        for(int i{0}; i < elementCount; ++i) {
+            switch(typeDistribution(generator)) {
+                case 0: {
+                    std::shared_ptr<B> pB { std::make_shared<B>() };
+                    pB->mValue = i; pB->mWeight = 0.5;
+                    collection.push_back(pB); variants.push_back(pB);
+                    break;
+                }
+                case 1: {
+                    std::shared_ptr<C> pC { std::make_shared<C>() };
+                    pC->mValue = i;
+                    collection.push_back(pC); variants.push_back(pC);
+                    break;
+                }
+                default: {
+                    std::shared_ptr<D> pD { std::make_shared<D>() };
+                    pD->mValue = i; pD->mWeight = 2.0;
+                    collection.push_back(pD); variants.push_back(pD);
+                    break;
+                }
+            }
+        }
+    }
+
+    Totals virtualTotals {};
+    const double virtualTime { timeMilliseconds([&]() {
+        for(int i{0}; i < repetitions; ++i) {
+            for(const auto& pElement: collection) {
+                pElement->update(virtualTotals);
+            }
+        }
+    }) };
+
+    Totals variantTotals {};
+    const double variantTime { timeMilliseconds([&]() {
+        for(int i{0}; i < repetitions; ++i) {
+            for(const auto& element: variants) {
+                std::visit([&variantTotals](const auto& pElement) {
+                    using T = typename std::decay_t<decltype(pElement)>::element_type;
+                    MyProcess<T>::processOne(*pElement, variantTotals);
+                }, element);
+            }
+        }
+    }) };
+
+    // Partitioning is paid once; the buckets can then be processed any
+    // number of times
+    std::unique_ptr<TypeBuckets<Base, B, C, D>> pBuckets {};
+    const double partitionTime { timeMilliseconds([&]() {
+        pBuckets = std::make_unique<TypeBuckets<Base, B, C, D>>(collection);
+    }) };
+
+    Totals bucketTotals {};
+    const double bucketTime { timeMilliseconds([&]() {
+        for(int i{0}; i < repetitions; ++i) {
+            pBuckets->forEachBucket([&bucketTotals](const auto& bucket) {
+                using T = typename std::decay_t<decltype(bucket)>::value_type::element_type;
+                MyProcess<T>::process(bucket, bucketTotals);
+            });
+            for(const auto& pElement: pBuckets->getUnbucketed()) {
+                pElement->update(bucketTotals);
+            }
+        }
+    }) };
+
+    // Summation order differs between approaches, so totals may differ in
+    // their last few digits
+    std::cout << elementCount << " elements, " << repetitions << " passes each: \n";
+    std::cout << "\tvirtual per element: " << virtualTime << "ms (total " << virtualTotals.mSum << ")\n";
+    std::cout << "\tvariant per element: " << variantTime << "ms (total " << variantTotals.mSum << ")\n";
+    std::cout << "\ttype buckets: " << bucketTime << "ms, plus " << partitionTime
+        << "ms to partition once (total " << bucketTotals.mSum << ")" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,437 @@
+/**
+ *   Builds a serializer on the SFINAE dispatch scheme demonstrated in
+ * GenericAndSubclassSpecificSharedPtrFunctionSpecializations.cpp. How a
+ * value is written is chosen at compile time, using the same categories:
+ *
+ *   - plain objects are written inline, field by field
+ *   - generic shared pointers are written by value wherever they appear
+ *   - shared pointers to Base_A subclasses are tracked by identity, so an
+ *     object shared across a graph (even a cyclic one) is written once and
+ *     referred to by id thereafter
+ *   - shared pointers to Base_C subclasses are tagged with their type name,
+ *     so that a reader knows which subclass to construct. The name is that
+ *     of the pointer's static type, as are the fields written; hold such
+ *     objects by pointers to their concrete type, or they're written as
+ *     the type pointed through
+ *
+ *   Output goes through a format (text or binary) into a caller supplied
+ * sink. Nothing is flushed per item; a stream sink leaves flushing to
+ * whoever owns the stream.
+ * 
+ *   NOTE: objects are written recursively, so a long chain of pointers
+ * (e.g. a linked list of many thousands of nodes) can exhaust the stack
+ */
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+class Base_A {};
+class Base_B {};
+class Base_C {};
+template <typename T, typename Enable=void>
+struct MySerialize;
+
+// Appends to a buffer owned by the caller
+class BufferSink {
+public:
+    explicit BufferSink(std::string& buffer): mBuffer { buffer } {}
+    void write(const char* data, std::size_t size) { mBuffer.append(data, size); }
+private:
+    std::string& mBuffer;
+};
+
+// Writes into a stream's own buffer, and never flushes it
+class StreamSink {
+public:
+    explicit StreamSink(std::ostream& stream): mStream { stream } {}
+    void write(const char* data, std::size_t size) { mStream.write(data, static_cast<std::streamsize>(size)); }
+private:
+    std::ostream& mStream;
+};
+
+// Human readable output, e.g. B#1{value: 3, next: @1}
+template <typename TSink>
+class TextFormat {
+public:
+    explicit TextFormat(TSink& sink): mSink { sink } {}
+
+    void beginObject(std::string_view typeName) { write(typeName); write("{"); mFirstInScope.push_back(true); }
+    // an object that later references may point back to
+    void beginIdentifiedObject(std::string_view typeName, std::uint64_t id) {
+        write(typeName); write("#"); writeNumber(id); write("{"); mFirstInScope.push_back(true);
+    }
+    void endObject() { write("}"); mFirstInScope.pop_back(); }
+    void beginField(std::string_view name) { separate(); write(name); write(": "); }
+
+    void beginList(std::size_t) { write("["); mFirstInScope.push_back(true); }
+    void beginElement() { separate(); }
+    void endList() { write("]"); mFirstInScope.pop_back(); }
+
+    void writeValue(std::int64_t value) { writeNumber(value); }
+    void writeValue(double value) { writeNumber(value); }
+    void writeValue(std::string_view value) {
+        write("\"");
+        // escape quotes and backslashes, writing the text between them as is
+        std::size_t spanStart { 0 };
+        for(std::size_t i{0}; i < value.size(); ++i) {
+            if(value[i] == '"' || value[i] == '\\') {
+                write(value.substr(spanStart, i - spanStart));
+                write("\\");
+                spanStart = i;
+            }
+        }
+        write(value.substr(spanStart));
+        write("\"");
+    }
+    void writeNull() { write("null"); }
+    void writeReference(std::uint64_t id) { write("@"); writeNumber(id); }
+
+private:
+    void write(std::string_view text) { mSink.write(text.data(), text.size()); }
+
+    template <typename TNumber>
+    void writeNumber(TNumber number) {
+        char digits[32];
+        const auto result { std::to_chars(digits, digits + sizeof(digits), number) };
+        mSink.write(digits, static_cast<std::size_t>(result.ptr - digits));
+    }
+
+    void separate() {
+        if(!mFirstInScope.back()) { write(", "); }
+        mFirstInScope.back() = false;
+    }
+
+    TSink& mSink;
+    std::vector<bool> mFirstInScope { true };
+};
+
+// Compact output. Every value starts with a one byte tag; field names are
+// left out, since a reader knows each type's field order. Numbers are
+// written in native byte order
+template <typename TSink>
+class BinaryFormat {
+public:
+    explicit BinaryFormat(TSink& sink): mSink { sink } {}
+
+    void beginObject(std::string_view typeName) { writeTag('t'); writeText(typeName); }
+    void beginIdentifiedObject(std::string_view typeName, std::uint64_t id) {
+        writeTag('a'); writeRaw(id); writeText(typeName);
+    }
+    void endObject() { writeTag('e'); }
+    void beginField(std::string_view) {}
+
+    void beginList(std::size_t size) { writeTag('l'); writeRaw(static_cast<std::uint64_t>(size)); }
+    void beginElement() {}
+    void endList() {}
+
+    void writeValue(std::int64_t value) { writeTag('i'); writeRaw(value); }
+    void writeValue(double value) { writeTag('d'); writeRaw(value); }
+    void writeValue(std::string_view value) { writeTag('s'); writeText(value); }
+    void writeNull() { writeTag('n'); }
+    void writeReference(std::uint64_t id) { writeTag('r'); writeRaw(id); }
+
+private:
+    void writeTag(char tag) { mSink.write(&tag, 1); }
+
+    template <typename TValue>
+    void writeRaw(TValue value) {
+        char bytes[sizeof(TValue)];
+        std::memcpy(bytes, &value, sizeof(TValue));
+        mSink.write(bytes, sizeof(TValue));
+    }
+
+    void writeText(std::string_view text) {
+        writeRaw(static_cast<std::uint32_t>(text.size()));
+        mSink.write(text.data(), text.size());
+    }
+
+    TSink& mSink;
+};
+
+template <typename TFormat>
+class Serializer {
+public:
+    explicit Serializer(TFormat& format): mFormat { format } {}
+
+    template <typename T>
+    void write(const T& value) {
+        // we wrap write in a struct to allow partial specializations.
+        MySerialize<T>::write(*this, value);
+    }
+
+    template <typename T>
+    void field(std::string_view name, const T& value) {
+        mFormat.beginField(name);
+        write(value);
+    }
+
+    TFormat& getFormat() { return mFormat; }
+
+    // The id given to an object on the first call for its address, and
+    // whether this is that first call
+    std::pair<std::uint64_t, bool> identify(const void* pObject) {
+        const auto result { mIds.insert({pObject, mIds.size() + 1}) };
+        return { result.first->second, result.second };
+    }
+
+private:
+    TFormat& mFormat;
+    std::unordered_map<const void*, std::uint64_t> mIds {};
+};
+
+// Generic plain object serializer
+template <typename T, typename Enable>
+struct MySerialize {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const T& value) {
+        serializer.getFormat().beginObject(T::getName());
+        value.serializeFields(serializer);
+        serializer.getFormat().endObject();
+    }
+};
+
+// Leaf values
+template <typename T>
+struct MySerialize<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const T& value) {
+        serializer.getFormat().writeValue(static_cast<std::int64_t>(value));
+    }
+};
+
+template <typename T>
+struct MySerialize<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const T& value) {
+        serializer.getFormat().writeValue(static_cast<double>(value));
+    }
+};
+
+template <>
+struct MySerialize<std::string> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const std::string& value) {
+        serializer.getFormat().writeValue(std::string_view{ value });
+    }
+};
+
+template <typename T>
+struct MySerialize<std::vector<T>> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const std::vector<T>& values) {
+        serializer.getFormat().beginList(values.size());
+        for(const T& value: values) {
+            serializer.getFormat().beginElement();
+            serializer.write(value);
+        }
+        serializer.getFormat().endList();
+    }
+};
+
+// Generic partially specialized shared ptr serializer; writes the
+// pointed-to object by value
+template <typename T, typename Enable>
+struct MySerialize<std::shared_ptr<T>, Enable> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const std::shared_ptr<T>& pValue) {
+        if(!pValue) { serializer.getFormat().writeNull(); return; }
+        serializer.write(*pValue);
+    }
+};
+
+// Base A specialized shared ptr serializer. Will be preferred by the compiler
+// for being more specialized than the generic partial specialization for
+// shared pointers
+template <typename T>
+struct MySerialize<std::shared_ptr<T>, typename std::enable_if<std::is_base_of<Base_A, T>::value>::type> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const std::shared_ptr<T>& pValue) {
+        if(!pValue) { serializer.getFormat().writeNull(); return; }
+
+        const auto [id, isFirstVisit] = serializer.identify(pValue.get());
+        if(!isFirstVisit) {
+            serializer.getFormat().writeReference(id);
+            return;
+        }
+        // the id is claimed before the fields are written, so that cycles
+        // back to this object end in a reference
+        serializer.getFormat().beginIdentifiedObject(T::getName(), id);
+        pValue->serializeFields(serializer);
+        serializer.getFormat().endObject();
+    }
+};
+
+//
+// NOTE: no specialization for Base B, so generic shared pointer version should be used
+//
+
+// Base C specialized shared ptr serializer. Will be preferred by the compiler
+// for being more specialized than the generic partial specialization for shared
+// pointers
+template <typename T>
+struct MySerialize<std::shared_ptr<T>, typename std::enable_if<std::is_base_of<Base_C, T>::value>::type> {
+    template <typename TSerializer>
+    static void write(TSerializer& serializer, const std::shared_ptr<T>& pValue) {
+        if(!pValue) { serializer.getFormat().writeNull(); return; }
+        // Tag and fields both come from T, the pointer's static type, so
+        // they always agree. Fields can't be written through the dynamic
+        // type (serializeFields is a template, so it can't be virtual), and
+        // tagging with it would label one type's fields as another's
+        serializer.getFormat().beginObject(T::getName());
+        pValue->serializeFields(serializer);
+        serializer.getFormat().endObject();
+    }
+};
+
+class B: public Base_A {
+public:
+    static std::string getName() { return "B"; }
+
+    template <typename TSerializer>
+    void serializeFields(TSerializer& serializer) const {
+        serializer.field("value", mValue);
+        serializer.field("next", mNext);
+    }
+
+    int mValue {};
+    std::shared_ptr<B> mNext {};
+};
+
+class C {
+public:
+    static std::string getName() { return "C"; }
+
+    template <typename TSerializer>
+    void serializeFields(TSerializer& serializer) const {
+        serializer.field("label", mLabel);
+    }
+
+    std::string mLabel {};
+};
+
+class D: public Base_B {
+public:
+    static std::string getName() { return "D"; }
+
+    template <typename TSerializer>
+    void serializeFields(TSerializer& serializer) const {
+        serializer.field("weight", mWeight);
+    }
+
+    double mWeight {};
+};
+
+class E: public Base_C {
+public:
+    static std::string getName() { return "E"; }
+
+    template <typename TSerializer>
+    void serializeFields(TSerializer& serializer) const {
+        serializer.field("count", mCount);
+    }
+
+    int mCount {};
+};
+
+// The collection written by main
+struct Scene {
+    static std::string getName() { return "Scene"; }
+
+    Scene() = default;
+    Scene(Scene&& other) = default;
+    Scene& operator=(Scene&& other) = default;
+
+    // Bs may link into cycles (makeScene's first B refers to itself), which
+    // shared pointers alone would never free, so the links are cut here
+    ~Scene() {
+        for(const auto& pB: mBs) {
+            if(pB) { pB->mNext.reset(); }
+        }
+    }
+
+    template <typename TSerializer>
+    void serializeFields(TSerializer& serializer) const {
+        serializer.field("bs", mBs);
+        serializer.field("cs", mCs);
+        serializer.field("ds", mDs);
+        serializer.field("es", mEs);
+    }
+
+    std::vector<std::shared_ptr<B>> mBs {};
+    std::vector<C> mCs {};
+    std::vector<std::shared_ptr<D>> mDs {};
+    std::vector<std::shared_ptr<E>> mEs {};
+};
+
+Scene makeScene(int size) {
+    Scene scene {};
+    for(int i{0}; i < size; ++i) {
+        scene.mBs.push_back(std::make_shared<B>());
+        scene.mBs.back()->mValue = i;
+        scene.mCs.push_back(C{ "c" + std::to_string(i) });
+        scene.mDs.push_back(std::make_shared<D>());
+        scene.mDs.back()->mWeight = i * 0.5;
+        scene.mEs.push_back(std::make_shared<E>());
+        scene.mEs.back()->mCount = i;
+    }
+    // point each B at one earlier in the list, so that most Bs are shared
+    // and the first one refers to itself
+    for(int i{0}; i < size; ++i) {
+        scene.mBs[i]->mNext = scene.mBs[i / 2];
+    }
+    return scene;
+}
+
+template <template <typename> class TFormat>
+double timeSerialization(const Scene& scene, std::string& buffer) {
+    constexpr int repetitions { 10 };
+    const auto start { std::chrono::steady_clock::now() };
+    for(int i{0}; i < repetitions; ++i) {
+        buffer.clear();
+        BufferSink sink { buffer };
+        TFormat<BufferSink> format { sink };
+        Serializer<TFormat<BufferSink>> serializer { format };
+        serializer.write(scene);
+    }
+    const auto end { std::chrono::steady_clock::now() };
+    return std::chrono::duration<double, std::milli>(end - start).count() / repetitions;
+}
+
+int main() {
+    // A small scene written straight to stdout, flushed once at the end
+    {
+        const Scene scene { makeScene(3) };
+        StreamSink sink { std::cout };
+        TextFormat<StreamSink> format { sink };
+        Serializer<TextFormat<StreamSink>> serializer { format };
+        serializer.write(scene);
+        std::cout << std::endl;
+    }
+    std::cout << "\n";
+
+    // A large scene written to buffers in both formats
+    {
+        const Scene scene { makeScene(100000) };
+        std::string buffer {};
+        buffer.reserve(16 * 1024 * 1024);
+
+        const double textTime { timeSerialization<TextFormat>(scene, buffer) };
+        std::cout << "Text: " << buffer.size() << " bytes in " << textTime << "ms ("
+            << buffer.size() / (textTime * 1000.0) << "MB/s)\n";
+
+        const double binaryTime { timeSerialization<BinaryFormat>(scene, buffer) };
+        std::cout << "Binary: " << buffer.size() << " bytes in " << binaryTime << "ms ("
+            << buffer.size() / (binaryTime * 1000.0) << "MB/s)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/**
+ *   Demonstrates a weak delegate: a callable bound to a member function of
+ * an object owned by a shared pointer, which neither keeps the object
+ * alive nor needs the object to store a std::function for it (compare
+ * WeakPtrToClassMemberFunction.cpp).
+ *
+ *   Each call through the delegate itself locks its weak pointer. Callers
+ * making many calls in a row can instead pin the delegate, locking once
+ * and then calling as often as they like while the pin is held.
+ */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+template <typename TSignature>
+class WeakDelegate;
+
+template <typename TReturn, typename ...TArgs>
+class WeakDelegate<TReturn(TArgs...)> {
+public:
+    // What tryInvoke() returns: whether the call was made, for void
+    // members, and otherwise the member's result if it was made. References
+    // are returned wrapped, since std::optional can't hold one
+    using InvokeResult = std::conditional_t<
+        std::is_void<TReturn>::value,
+        bool,
+        std::optional<std::conditional_t<
+            std::is_reference<TReturn>::value,
+            std::reference_wrapper<std::remove_reference_t<TReturn>>,
+            TReturn
+        >>
+    >;
+
+    // A locked delegate. Keeps the object alive, and so can be called
+    // without further checks, for as long as it exists
+    class Pin {
+    public:
+        explicit operator bool() const { return static_cast<bool>(mOwner); }
+
+        // Only valid on a pin that tested true
+        TReturn operator()(TArgs... args) const {
+            return mTrampoline(mObject, std::forward<TArgs>(args)...);
+        }
+
+    private:
+        Pin(std::shared_ptr<void> owner, void* pObject, TReturn (*trampoline)(void*, TArgs...)):
+        mOwner { std::move(owner) }, mObject { pObject }, mTrampoline { trampoline }
+        {}
+
+        std::shared_ptr<void> mOwner {};
+        void* mObject { nullptr };
+        TReturn (*mTrampoline)(void*, TArgs...) { nullptr };
+
+    friend class WeakDelegate;
+    };
+
+    WeakDelegate() = default;
+
+    // e.g. WeakDelegate<void(int)>::bind<&A::printSomething>(shrd_A)
+    template <auto TMemberFunction, typename TObject>
+    static WeakDelegate bind(const std::shared_ptr<TObject>& owner) {
+        WeakDelegate delegate {};
+        delegate.mOwner = owner;
+        delegate.mObject = const_cast<void*>(static_cast<const void*>(owner.get()));
+        delegate.mTrampoline = &invokeMember<TMemberFunction, TObject>;
+        return delegate;
+    }
+
+    bool expired() const { return mOwner.expired(); }
+
+    // Locks once; test the result before calling it
+    Pin pin() const {
+        return Pin { mOwner.lock(), mObject, mTrampoline };
+    }
+
+    // Locks, and calls the member function if the object still exists
+    InvokeResult tryInvoke(TArgs... args) const {
+        const Pin pinned { pin() };
+        if constexpr (std::is_void<TReturn>::value) {
+            if(pinned) {
+                pinned(std::forward<TArgs>(args)...);
+                return true;
+            }
+            return false;
+        } else {
+            if(pinned) {
+                return InvokeResult{ pinned(std::forward<TArgs>(args)...) };
+            }
+            return std::nullopt;
+        }
+    }
+
+private:
+    template <auto TMemberFunction, typename TObject>
+    static TReturn invokeMember(void* pObject, TArgs... args) {
+        return (static_cast<TObject*>(pObject)->*TMemberFunction)(std::forward<TArgs>(args)...);
+    }
+
+    std::weak_ptr<void> mOwner {};
+    void* mObject { nullptr };
+    TReturn (*mTrampoline)(void*, TArgs...) { nullptr };
+};
+
+class A{
+public:
+    void printSomething(int a) const;
+    void accumulate(int a) { mTotal += a; }
+    long long getTotal() const { return mTotal; }
+
+    long long mTotal { 0 };
+    // only needed by the std::function based pattern in the benchmark
+    std::function<void(int)> otherAccumulate = std::bind(&A::accumulate, this, std::placeholders::_1);
+};
+
+void A::printSomething(int a) const {
+    std::cout << "Printing Something: " << a << std::endl;
+}
+
+template <typename TFunction>
+double timeMilliseconds(TFunction&& function) {
+    const auto start { std::chrono::steady_clock::now() };
+    function();
+    const auto end { std::chrono::steady_clock::now() };
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+
+    WeakDelegate<void(int)> weak_print {};
+    {
+        // A shared reference to a dynamically allocated instance of A, valid
+        // only within the scope of this block
+        std::shared_ptr<A> shrd_A { std::make_shared<A>() };
+
+        // Nothing stored in A for the delegate to point at
+        weak_print = WeakDelegate<void(int)>::bind<&A::printSomething>(shrd_A);
+
+        // one lock per call
+        weak_print.tryInvoke(8);
+
+        // one lock for several calls
+        if(const auto pinned { weak_print.pin() }) {
+            pinned(2);
+            pinned(3);
+        }
+
+        // members with a result hand it back, if they could be called
+        const auto weak_total { WeakDelegate<long long()>::bind<&A::getTotal>(shrd_A) };
+        std::cout << "total: " << weak_total.tryInvoke().value_or(-1) << "\n";
+    }
+
+    // A is gone, so nothing is printed here
+    std::cout << "expired: " << weak_print.expired() << ", invoked: " << weak_print.tryInvoke(4) << "\n\n";
+
+    // A callback heavy loop, through each pattern
+    constexpr int callCount { 10000000 };
+    std::shared_ptr<A> shrd_A { std::make_shared<A>() };
+
+    const std::weak_ptr<std::function<void(int)>> weak_function {
+        std::shared_ptr<std::function<void(int)>>{ shrd_A, &shrd_A->otherAccumulate }
+    };
+    const double functionTime { timeMilliseconds([&]() {
+        for(int i{0}; i < callCount; ++i) {
+            if(auto locked = weak_function.lock()) { (*locked)(i); }
+        }
+    }) };
+
+    const WeakDelegate<void(int)> weak_accumulate { WeakDelegate<void(int)>::bind<&A::accumulate>(shrd_A) };
+    const double delegateTime { timeMilliseconds([&]() {
+        for(int i{0}; i < callCount; ++i) {
+            weak_accumulate.tryInvoke(i);
+        }
+    }) };
+
+    const double pinnedTime { timeMilliseconds([&]() {
+        if(const auto pinned { weak_accumulate.pin() }) {
+            for(int i{0}; i < callCount; ++i) {
+                pinned(i);
+            }
+        }
+    }) };
+
+    std::cout << callCount << " calls: \n";
+    std::cout << "\tlocked std::function per call: " << functionTime << "ms\n";
+    std::cout << "\tlocked delegate per call: " << delegateTime << "ms\n";
+    std::cout << "\tpinned delegate: " << pinnedTime << "ms\n";
+    std::cout << "\t(total " << shrd_A->mTotal << ")" << std::endl;
+
+    return 0;
+}